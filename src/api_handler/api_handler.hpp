@@ -1,5 +1,7 @@
 #pragma once
 
+#include <optional>
+
 #include "model/model.hpp"
 #include "util/response.hpp"
 
@@ -13,23 +15,58 @@ using verb = boost::beast::http::verb;
 
 class APIHandler {
   public:
-    APIHandler(model::Game &game) : game_(game), endpoints_(GetEndpoints(game_)) {}
+    APIHandler(model::Game &game) : game_(game), endpoints_(game_) {}
 
+    // signed_player is the one found by precheck. The response body may refer to output,
+    // which must be kept until the response is written
     template <typename Body, typename Allocator>
-    bool dispatch(const http::request<Body, http::basic_fields<Allocator>> &request, Response &response) const {
-        for (const auto &endpoint : endpoints_) {
-            if (endpoint->match(request)) {
-                response = endpoint->handle(request);
-                return true;
-            }
+    bool dispatch(const http::request<Body, http::basic_fields<Allocator>> &request,
+                  const boost::json::storage_ptr &storage,
+                  const std::optional<model::TokenSigner::Payload> &signed_player, std::string &output,
+                  Response &response) const {
+        if (auto match = Endpoints::Find(request.target())) {
+            response = endpoints_.Handle(*match, request, output, storage, signed_player);
+            return true;
+        }
+        if (request.target().starts_with("/api/")) {
+            response = model::api::errors::invalid_endpoint();
+            return true;
         }
 
         return false;
     }
 
+    // May be called off api_strand: a forged signed token is rejected without touching the game,
+    // the player of a valid one is passed to dispatch, so the token isn't verified again
+    template <typename Body, typename Allocator>
+    std::optional<Response> precheck(const http::request<Body, http::basic_fields<Allocator>> &request,
+                                     std::optional<model::TokenSigner::Payload> &signed_player) const {
+        const auto *signer = game_.GetTokenSigner();
+        if (!signer) {
+            return std::nullopt;
+        }
+
+        // A missing token is reported by the endpoint itself
+        auto match = Endpoints::Find(request.target());
+        std::string_view authorization_prefix = "Bearer ";
+        if (!match || !Endpoints::IsAuthorized(match->route) || !request.count("Authorization") ||
+            !request["Authorization"].starts_with(authorization_prefix)) {
+            return std::nullopt;
+        }
+        std::string_view token = request["Authorization"];
+        token.remove_prefix(authorization_prefix.size());
+
+        auto value = model::Token::FromHex(token);
+        if (!value || !(signed_player = signer->Verify(*value))) {
+            return model::api::errors::no_user_found();
+        }
+        return std::nullopt;
+    }
+
   private:
     model::Game &game_;
-    std::vector<std::shared_ptr<Endpoint>> endpoints_;
+    // Endpoints are only called on api_strand
+    mutable Endpoints endpoints_;
 };
 
 } // namespace api_handler
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "api_handler/router.hpp"
 #include "model/model.hpp"
 #include "util/error.hpp"
 #include "util/response.hpp"
@@ -10,12 +11,19 @@ namespace beast = boost::beast;
 namespace http = beast::http;
 namespace json = boost::json;
 
+// Base of the endpoints: a derived class declares its route pattern and
+// util::Response handle(const http::request<http::string_body> &request), see api_handler::Router
 class Endpoint {
   public:
     Endpoint(model::Game &game) : game_(game) {}
-    virtual bool match(const http::request<http::string_body> &request) = 0;
-    virtual util::Response handle(const http::request<http::string_body> &request) = 0;
+    // Whether the endpoint expects a player token in the Authorization header
+    static constexpr bool authorized = false;
 
   protected:
+    // The signed token has been verified before the request got to api_strand, only the player is looked up
+    model::Player *FindPlayer(std::string_view token, const api_handler::RequestContext &context) {
+        return context.signed_player ? game_.GetPlayer(*context.signed_player) : game_.GetPlayer(token);
+    }
+
     model::Game &game_;
 };
\ No newline at end of file
@@ -1,13 +1,17 @@
 #pragma once
 
 #include "api_handler/endpoints/endpoint.hpp"
+#include "util/etag.hpp"
 #include <string_view>
 
 class GetPlayersEndpoint : public Endpoint {
   public:
-    using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override { return request.target() == endpoint; }
-    util::Response handle(const http::request<http::string_body> &request) override {
+    static constexpr std::string_view route{"/api/v1/game/players"};
+    static constexpr bool authorized = true;
+
+    GetPlayersEndpoint(model::Game &game)
+        : Endpoint(game), etag_prefix_(util::MakeVersionETagPrefix("players")) {}
+    util::Response handle(const http::request<http::string_body> &request, const api_handler::RequestContext &context) {
         auto method = request.method();
 
         // TODO: Пустой токен засчитывается за валидный, исправить
@@ -19,25 +23,35 @@ class GetPlayersEndpoint : public Endpoint {
         } else {
             std::string_view token = request["Authorization"];
             token.remove_prefix(authorization_prefix.size());
-            return execute(token);
+            return execute(FindPlayer(token, context), request[http::field::if_none_match]);
         }
     }
-    util::Response execute(std::string_view token) {
-        auto player = game_.GetPlayer(token);
+    util::Response execute(model::Player *player, std::string_view if_none_match) {
         if (!player) {
             return model::api::errors::no_user_found();
         }
-        const auto &players = game_.GetPlayers(player->GetSession().GetMap().GetId());
-        return responses::ok(players);
+
+        // Список игроков меняется только при входе и выходе игроков
+        auto &session = player->GetSession();
+        // Versions of the sessions are counted separately, so the tag names the session too
+        auto etag = util::MakeVersionETag(etag_prefix_, {session.GetMapHandle(), session.GetInstance()},
+                                          session.GetPlayersVersion());
+        if (util::MatchesETag(if_none_match, etag)) {
+            return util::Response::NotModified(etag);
+        }
+        const auto &body = session.GetPlayersCache().Get(session.GetPlayersVersion(), [&] {
+            return std::make_shared<const std::string>(
+                util::ToJson(model::api::responses::GetPlayersResponse{.session = session}));
+        });
+        return responses::ok(body).etag(etag);
     }
 
   private:
     struct responses {
-        static util::Response ok(const std::unordered_map<model::Player::Id, std::shared_ptr<model::Player>> &players) {
-            return util::Response::Json(http::status::ok,
-                                        json::value_from(model::api::responses::GetPlayersResponse{.players = players}))
-                .no_cache();
+        static util::Response ok(std::shared_ptr<const std::string> body) {
+            return util::Response::Json(http::status::ok, std::move(body)).no_cache();
         }
     };
-    static constexpr std::string_view endpoint{"/api/v1/game/players"};
+
+    std::string etag_prefix_;
 };
\ No newline at end of file
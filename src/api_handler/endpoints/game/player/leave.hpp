@@ -0,0 +1,37 @@
+#pragma once
+
+#include "api_handler/endpoints/endpoint.hpp"
+#include "api_handler/router.hpp"
+#include "model/domains/api.hpp"
+
+class LeaveEndpoint : public Endpoint {
+  public:
+    static constexpr std::string_view route{"/api/v1/game/player/leave"};
+    static constexpr bool authorized = true;
+
+    using Endpoint::Endpoint;
+    util::Response handle(const http::request<http::string_body> &request, const api_handler::RequestContext &) {
+        std::string_view authorization_prefix = "Bearer ";
+        if (!request.count("Authorization") || !request["Authorization"].starts_with(authorization_prefix)) {
+            return model::api::errors::no_token();
+        } else if (request.method() != http::verb::post) {
+            return model::api::errors::only_post();
+        }
+
+        std::string_view token = request["Authorization"];
+        token.remove_prefix(authorization_prefix.size());
+        return execute(token);
+    }
+    util::Response execute(std::string_view token) {
+        auto value = model::Token::FromHex(token);
+        if (!value || !game_.RemovePlayer(*value)) {
+            return model::api::errors::no_user_found();
+        }
+        return responses::ok();
+    }
+
+  private:
+    struct responses {
+        static util::Response ok() { return util::Response::Json(http::status::ok, json::object()).no_cache(); }
+    };
+};
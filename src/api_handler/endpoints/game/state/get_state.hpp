@@ -1,39 +1,113 @@
 #pragma once
 
 #include "api_handler/endpoints/endpoint.hpp"
+#include "util/etag.hpp"
+#include <charconv>
+#include <optional>
+#include <string_view>
 
 class GetStateEndpoint : public Endpoint {
   public:
-    using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override { return request.target() == endpoint; }
-    util::Response handle(const http::request<http::string_body> &request) override {
+    static constexpr std::string_view route{"/api/v1/game/state"};
+    static constexpr bool authorized = true;
+
+    GetStateEndpoint(model::Game &game)
+        : Endpoint(game), etag_prefix_(util::MakeVersionETagPrefix("state")),
+          delta_etag_prefix_(util::MakeVersionETagPrefix("state-delta")) {}
+    util::Response handle(const http::request<http::string_body> &request, const api_handler::RequestContext &context) {
         auto method = request.method();
 
         // TODO: Пустой токен засчитывается за валидный, исправить
-        if (!request.count("Authorization") || !request["Authorization"].starts_with("Authorization: Bearer ")) {
+        std::string_view authorization_prefix = "Bearer ";
+        if (!request.count("Authorization") || !request["Authorization"].starts_with(authorization_prefix)) {
             return model::api::errors::no_token();
         } else if (method != http::verb::get && method != http::verb::head) {
             return model::api::errors::only_get_and_head();
-        } else {
-            return execute(request["Authorization"]);
         }
+
+        std::string_view token = request["Authorization"];
+        token.remove_prefix(authorization_prefix.size());
+
+        // Клиент может передать версию последнего полученного состояния: ?since=<version>.
+        // Прочие параметры, например добавленные против кеширования, игнорируются
+        std::optional<model::GameSession::Version> since;
+        std::string_view target = request.target();
+        if (auto query = target.find('?'); query != std::string_view::npos) {
+            auto parameter = find_parameter(target.substr(query + 1), "since");
+            if (parameter) {
+                since = parse_version(*parameter);
+                if (!since) {
+                    return model::api::errors::parse_error();
+                }
+            }
+        }
+        return execute(FindPlayer(token, context), since, request[http::field::if_none_match], context.output);
     }
-    util::Response execute(std::string token) {
-        auto player = game_.GetPlayer(token);
+    util::Response execute(model::Player *player, std::optional<model::GameSession::Version> since,
+                           std::string_view if_none_match, std::string &output) {
         if (!player) {
             return model::api::errors::no_user_found();
         }
-        const auto &players = game_.GetPlayers(player->GetSession()->GetMap()->GetId());
-        return responses::ok(players);
+
+        // Ответ определяется версией сессии, неизменившееся состояние не сериализуется
+        auto &session = player->GetSession();
+        // Versions of the sessions are counted separately, so the tag names the session too.
+        // A delta depends on the version it starts from as well, so it gets its own tag
+        const auto etag =
+            since ? util::MakeVersionETag(delta_etag_prefix_, {session.GetMapHandle(), session.GetInstance(), *since},
+                                          session.GetVersion())
+                  : util::MakeVersionETag(etag_prefix_, {session.GetMapHandle(), session.GetInstance()},
+                                          session.GetVersion());
+        if (util::MatchesETag(if_none_match, etag)) {
+            return util::Response::NotModified(etag);
+        }
+        const auto precision = game_.GetCoordinatePrecision();
+        return (since ? responses::delta(session, *since, precision, output) : responses::ok(session, precision))
+            .etag(etag);
     }
 
   private:
+    // Value of the first parameter with the name in a query string
+    static std::optional<std::string_view> find_parameter(std::string_view query, std::string_view name) {
+        while (!query.empty()) {
+            const auto ampersand = query.find('&');
+            auto parameter = query.substr(0, ampersand);
+            query.remove_prefix(ampersand == std::string_view::npos ? query.size() : ampersand + 1);
+
+            if (parameter.starts_with(name) && parameter.substr(name.size()).starts_with('=')) {
+                return parameter.substr(name.size() + 1);
+            }
+        }
+        return std::nullopt;
+    }
+
+    static std::optional<model::GameSession::Version> parse_version(std::string_view value) {
+        model::GameSession::Version version;
+        auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), version);
+        if (ec != std::errc{} || end != value.data() + value.size()) {
+            return std::nullopt;
+        }
+        return version;
+    }
+
     struct responses {
-        static util::Response ok(const std::unordered_map<model::Player::Id, std::shared_ptr<model::Player>> &players) {
-            return util::Response::Json(http::status::ok,
-                                        json::value_from(model::api::responses::GetStateResponse{players}))
+        static util::Response ok(model::GameSession &session, std::optional<int> precision) {
+            const auto &body = session.GetStateCache().Get(session.GetVersion(), [&] {
+                return std::make_shared<const std::string>(
+                    util::ToJson(model::api::responses::GetStateResponse{session}, precision));
+            });
+            return util::Response::Json(http::status::ok, body).no_cache();
+        }
+        // The delta depends on the client, so it is written into the buffer of the request instead of being cached
+        static util::Response delta(const model::GameSession &session, model::GameSession::Version since,
+                                    std::optional<int> precision, std::string &output) {
+            return util::Response::Borrowed(
+                       http::status::ok, "application/json",
+                       util::ToJson(model::api::responses::GetStateDeltaResponse{session, since}, output, precision))
                 .no_cache();
         }
     };
-    static constexpr std::string_view endpoint{"/api/v1/game/state"};
-};
\ No newline at end of file
+
+    std::string etag_prefix_;
+    std::string delta_etag_prefix_;
+};
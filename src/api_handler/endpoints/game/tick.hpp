@@ -1,18 +1,24 @@
 #pragma once
 
 #include "api_handler/endpoints/endpoint.hpp"
+#include "api_handler/router.hpp"
+#include "model/domains/api.hpp"
 #include <chrono>
 
 class TickEndpoint : public Endpoint {
   public:
+    static constexpr std::string_view route{"/api/v1/game/tick"};
+
     using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override { return request.target() == endpoint; }
-    util::Response handle(const http::request<http::string_body> &request) override {
+    util::Response handle(const http::request<http::string_body> &request, const api_handler::RequestContext &context) {
         if (game_.GetTickPeriod().has_value())
             return model::api::errors::invalid_endpoint();
+        if (request.method() != http::verb::post)
+            return model::api::errors::only_post();
 
         try {
-            auto [timedelta] = value_to<model::api::requests::TickRequest>(boost::json::parse(request.body()));
+            auto [timedelta] =
+                value_to<model::api::requests::TickRequest>(boost::json::parse(request.body(), context.storage));
             return execute(timedelta);
         } catch (...) {
             return model::api::errors::parse_error();
@@ -25,7 +31,6 @@ class TickEndpoint : public Endpoint {
 
   private:
     struct responses {
-        static util::Response ok() { return util::Response::Json(http::status::ok, json::value()).no_cache(); }
+        static util::Response ok() { return util::Response::Json(http::status::ok, json::object()).no_cache(); }
     };
-    static constexpr std::string_view endpoint{"/api/v1/game/tick"};
 };
\ No newline at end of file
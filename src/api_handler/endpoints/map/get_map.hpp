@@ -1,30 +1,43 @@
 #pragma once
 
 #include "api_handler/endpoints/endpoint.hpp"
+#include "api_handler/router.hpp"
 #include "model/domains/api.hpp"
+#include "util/etag.hpp"
+
+#include <unordered_map>
 
 class GetMapEndpoint : public Endpoint {
   public:
-    using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override {
-        return request.target().starts_with(endpoint) && !request.target().ends_with(endpoint);
+    static constexpr std::string_view route{"/api/v1/maps/{id}"};
+
+    // Maps don't change after loading, so every map is serialized once
+    GetMapEndpoint(model::Game &game) : Endpoint(game) {
+        for (const auto &map : game_.GetMaps()) {
+            documents_.emplace(map.GetId(), util::Document{util::ToJson(map)});
+        }
     }
-    util::Response handle(const http::request<http::string_body> &request) override {
-        std::string_view map_ident = request.target().substr(endpoint.size());
-        return execute(model::Map::Id{std::string{map_ident}});
+    util::Response handle(const http::request<http::string_body> &request, const api_handler::RequestContext &context) {
+        return execute(model::Map::Id{std::string{context.params[0]}}, request[http::field::if_none_match]);
     }
-    util::Response execute(model::Map::Id map_ident) {
-        if (!game_.ContainsMap(map_ident))
+    util::Response execute(model::Map::Id map_ident, std::string_view if_none_match) {
+        auto it = documents_.find(map_ident);
+        if (it == documents_.end()) {
             return model::api::errors::map_not_found();
-        else
-            return responses::ok(game_.GetMap(map_ident));
+        }
+
+        const auto &document = it->second;
+        if (util::MatchesETag(if_none_match, document.etag)) {
+            return util::Response::NotModified(document.etag);
+        }
+        return responses::ok(document);
     }
 
   private:
     struct responses {
-        static util::Response ok(const model::Map &map) {
-            return util::Response::Json(http::status::ok, json::value_from(map));
+        static util::Response ok(const util::Document &document) {
+            return util::Response::Json(http::status::ok, document.body).etag(document.etag);
         }
     };
-    static constexpr std::string_view endpoint{"/api/v1/maps/"};
-};
\ No newline at end of file
+    std::unordered_map<model::Map::Id, util::Document> documents_;
+};
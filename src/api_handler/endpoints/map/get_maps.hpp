@@ -1,18 +1,28 @@
 #pragma once
 
 #include "api_handler/endpoints/endpoint.hpp"
+#include "util/etag.hpp"
 
 class GetMapsEndpoint : public Endpoint {
   public:
-    using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override { return request.target() == endpoint; }
-    util::Response handle(const http::request<http::string_body> &request) override { return responses::ok(game_); }
+    static constexpr std::string_view route{"/api/v1/maps"};
+
+    // The list of maps doesn't change after loading, so it is serialized once
+    GetMapsEndpoint(model::Game &game)
+        : Endpoint(game), document_(util::ToJson(game_.GetMaps())) {}
+    util::Response handle(const http::request<http::string_body> &request) {
+        if (util::MatchesETag(request[http::field::if_none_match], document_.etag)) {
+            return util::Response::NotModified(document_.etag);
+        }
+        return responses::ok(document_);
+    }
 
   private:
     struct responses {
-        static util::Response ok(model::Game &game_) {
-            return util::Response::Json(http::status::ok, json::value_from(game_.GetMaps()));
+        static util::Response ok(const util::Document &document) {
+            return util::Response::Json(http::status::ok, document.body).etag(document.etag);
         }
     };
-    static constexpr std::string_view endpoint{"/api/v1/maps"};
-};
\ No newline at end of file
+
+    util::Document document_;
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <boost/json.hpp>
+
+#include "model/model.hpp"
+#include "util/response.hpp"
+
+namespace api_handler {
+
+// Values of the {parameters} of the matched route in the order of the pattern
+class PathParams {
+  public:
+    static constexpr std::size_t max_size = 4;
+
+    std::string_view operator[](std::size_t index) const noexcept { return values_[index]; }
+
+    std::size_t size() const noexcept { return size_; }
+
+    void push_back(std::string_view value) noexcept { values_[size_++] = value; }
+
+    void pop_back() noexcept { --size_; }
+
+  private:
+    std::array<std::string_view, max_size> values_;
+    std::size_t size_ = 0;
+};
+
+struct RouteMatch {
+    std::size_t route;
+    PathParams params;
+};
+
+// What an endpoint gets besides the request
+struct RequestContext {
+    const PathParams &params;
+    // Memory for the JSON documents of the request, see util::RequestArena
+    boost::json::storage_ptr storage;
+    // Player of the signed token, which has already been verified off api_strand
+    std::optional<model::TokenSigner::Payload> signed_player;
+    // Buffer for the serialized body, see util::RequestArena::GetOutput
+    std::string &output;
+};
+
+// Nodes a trie of the patterns needs at most: one per segment and the root
+template <std::size_t RouteCount>
+constexpr std::size_t CountRouteNodes(const std::array<std::string_view, RouteCount> &patterns) {
+    std::size_t count = 1;
+    for (auto pattern : patterns) {
+        count += std::count(pattern.begin(), pattern.end(), '/');
+    }
+    return count;
+}
+
+// Segment trie of route patterns built at compile time.
+// A pattern is an absolute path like "/api/v1/maps/{id}"; a segment in braces matches any non-empty segment,
+// literal segments take precedence over it. The query string of a target is ignored
+template <std::size_t RouteCount, std::size_t MaxNodes>
+class RouteTrie {
+  public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // Doesn't compile for an invalid or a repeated pattern
+    constexpr explicit RouteTrie(const std::array<std::string_view, RouteCount> &patterns) {
+        for (std::size_t route = 0; route < RouteCount; ++route) {
+            auto path = patterns[route];
+            if (!path.starts_with('/')) {
+                throw std::invalid_argument("Route pattern must start with /");
+            }
+
+            std::size_t node = 0;
+            std::size_t params = 0;
+            while (!path.empty()) {
+                auto segment = NextSegment(path);
+                const bool param = segment.size() >= 2 && segment.front() == '{' && segment.back() == '}';
+                params += param;
+                node = AddChild(node, param ? std::string_view{} : segment, param);
+            }
+            if (nodes_[node].route != npos || params > PathParams::max_size) {
+                throw std::invalid_argument("Route pattern is repeated or has too many parameters");
+            }
+            nodes_[node].route = route;
+        }
+    }
+
+    std::optional<RouteMatch> Find(std::string_view target) const noexcept {
+        auto path = target.substr(0, target.find('?'));
+        if (!path.starts_with('/')) {
+            return std::nullopt;
+        }
+
+        RouteMatch match{};
+        if (!Find(0, path, match.params, match.route)) {
+            return std::nullopt;
+        }
+        return match;
+    }
+
+  private:
+    struct Node {
+        // Empty for a parameter
+        std::string_view segment;
+        bool param = false;
+        std::size_t first_child = npos;
+        std::size_t next_sibling = npos;
+        std::size_t route = npos;
+    };
+
+    // Remove "/segment" from the front of the path
+    static constexpr std::string_view NextSegment(std::string_view &path) noexcept {
+        path.remove_prefix(1);
+        const auto end = std::min(path.find('/'), path.size());
+        auto segment = path.substr(0, end);
+        path.remove_prefix(end);
+        return segment;
+    }
+
+    constexpr std::size_t AddChild(std::size_t parent, std::string_view segment, bool param) {
+        for (auto child = nodes_[parent].first_child; child != npos; child = nodes_[child].next_sibling) {
+            if (nodes_[child].param == param && nodes_[child].segment == segment) {
+                return child;
+            }
+        }
+        nodes_[size_] = {segment, param, npos, nodes_[parent].first_child, npos};
+        nodes_[parent].first_child = size_;
+        return size_++;
+    }
+
+    // Literal children are tried before parameters, so "/maps/new" wins over "/maps/{id}"
+    bool Find(std::size_t node, std::string_view path, PathParams &params, std::size_t &route) const noexcept {
+        if (path.empty()) {
+            route = nodes_[node].route;
+            return route != npos;
+        }
+
+        const auto segment = NextSegment(path);
+        for (bool param : {false, true}) {
+            for (auto child = nodes_[node].first_child; child != npos; child = nodes_[child].next_sibling) {
+                if (nodes_[child].param != param) {
+                    continue;
+                }
+                if (param ? segment.empty() : nodes_[child].segment != segment) {
+                    continue;
+                }
+                if (param) {
+                    params.push_back(segment);
+                }
+                if (Find(child, path, params, route)) {
+                    return true;
+                }
+                if (param) {
+                    params.pop_back();
+                }
+            }
+        }
+        return false;
+    }
+
+    std::array<Node, MaxNodes> nodes_{};
+    std::size_t size_ = 1;
+};
+
+// Dispatches requests to the endpoints by the route every endpoint declares:
+// static constexpr std::string_view route and static constexpr bool authorized.
+// The trie of routes is built at compile time, handlers are called directly, without virtual calls.
+// An endpoint may take the RequestContext as the second argument of handle
+template <typename... Endpoints>
+class Router {
+  public:
+    explicit Router(model::Game &game) : endpoints_(Endpoints(game)...) {}
+
+    static std::optional<RouteMatch> Find(std::string_view target) noexcept { return trie.Find(target); }
+
+    // Whether the endpoint of the route expects a player token in the Authorization header
+    static bool IsAuthorized(std::size_t route) noexcept { return authorized[route]; }
+
+    template <typename Request>
+    util::Response Handle(const RouteMatch &match, const Request &request, std::string &output,
+                          boost::json::storage_ptr storage = {},
+                          std::optional<model::TokenSigner::Payload> signed_player = std::nullopt) {
+        return Handle(match.route, request, RequestContext{match.params, std::move(storage), signed_player, output},
+                      std::index_sequence_for<Endpoints...>{});
+    }
+
+  private:
+    static constexpr std::array<std::string_view, sizeof...(Endpoints)> patterns{Endpoints::route...};
+    static constexpr std::array<bool, sizeof...(Endpoints)> authorized{Endpoints::authorized...};
+
+    static constexpr RouteTrie<sizeof...(Endpoints), CountRouteNodes(patterns)> trie{patterns};
+
+    template <typename Request, std::size_t... Indices>
+    util::Response Handle(std::size_t route, const Request &request, const RequestContext &context,
+                          std::index_sequence<Indices...>) {
+        util::Response response;
+        ((route == Indices && (response = Call(std::get<Indices>(endpoints_), request, context), true)) || ...);
+        return response;
+    }
+
+    template <typename Endpoint, typename Request>
+    static util::Response Call(Endpoint &endpoint, const Request &request, const RequestContext &context) {
+        if constexpr (requires { endpoint.handle(request, context); }) {
+            return endpoint.handle(request, context);
+        } else {
+            return endpoint.handle(request);
+        }
+    }
+
+    std::tuple<Endpoints...> endpoints_;
+};
+
+} // namespace api_handler
@@ -0,0 +1,342 @@
+#include "game_journal.hpp"
+
+#include <boost/asio/post.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "game_snapshot.hpp"
+#include "util/logging.hpp"
+
+namespace game_journal {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::array<char, 8> magic{'D', 'O', 'G', 'J', 'R', 'N', 'L', '\0'};
+constexpr std::uint32_t version = 4;
+
+// Records are written in the background once this much is buffered between ticks
+constexpr std::size_t commit_size = 64 * 1024;
+
+struct FileHeader {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t epoch;
+};
+
+enum class RecordType : std::uint32_t {
+    // Zero-filled tail of a file after a crash
+    NONE = 0,
+    JOIN = 1,
+    ACTION = 2,
+    TICK = 3,
+    LEAVE = 4,
+};
+
+struct RecordHeader {
+    RecordType type;
+    std::uint32_t size;
+};
+
+// Followed by map id and name
+struct JoinRecord {
+    std::uint64_t dog_id;
+    model::Token token;
+    model::DogStore::DogState state;
+    std::uint32_t instance;
+    std::uint32_t map_id_size;
+    std::uint32_t name_size;
+};
+
+// Followed by map id
+struct ActionRecord {
+    std::uint64_t dog_id;
+    model::Direction direction;
+    std::uint32_t map_id_size;
+};
+
+struct TickRecord {
+    double milliseconds;
+};
+
+struct LeaveRecord {
+    model::Token token;
+};
+
+void WriteAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const auto written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Failed to write journal");
+        }
+        data.remove_prefix(written);
+    }
+}
+
+void Sync(int fd) {
+    if (::fdatasync(fd) != 0) {
+        throw std::system_error(errno, std::generic_category(), "Failed to sync journal");
+    }
+}
+
+// Journal of a finished epoch is kept as <journal>.<epoch> until a saved snapshot covers it
+std::filesystem::path GetEpochPath(std::filesystem::path path, std::uint64_t epoch) {
+    path += "." + std::to_string(epoch);
+    return path;
+}
+
+using EpochFiles = std::vector<std::pair<std::uint64_t, std::filesystem::path>>;
+
+// Journals of the finished epochs ordered by epoch
+EpochFiles FindEpochFiles(const std::filesystem::path &path) {
+    const auto directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path{"."};
+    const auto prefix = path.filename().string() + ".";
+
+    EpochFiles files;
+    if (!std::filesystem::is_directory(directory)) {
+        return files;
+    }
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        const auto name = entry.path().filename().string();
+        if (!name.starts_with(prefix)) {
+            continue;
+        }
+        std::uint64_t epoch;
+        const auto *first = name.data() + prefix.size(), *last = name.data() + name.size();
+        const auto [end, ec] = std::from_chars(first, last, epoch);
+        if (ec == std::errc{} && end == last && first != last) {
+            files.emplace_back(epoch, entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+void Apply(model::Game &game, RecordType type, util::BinaryReader &reader) {
+    switch (type) {
+    case RecordType::JOIN: {
+        const auto record = reader.Read<JoinRecord>();
+        auto map_id = reader.ReadString(record.map_id_size);
+        auto name = reader.ReadString(record.name_size);
+        game.RestorePlayer(model::Map::Id{std::move(map_id)}, record.instance, model::Dog::Id{record.dog_id},
+                           std::move(name), record.token, record.state);
+        break;
+    }
+    case RecordType::ACTION: {
+        const auto record = reader.Read<ActionRecord>();
+        const auto map_id = reader.ReadString(record.map_id_size);
+        game.MovePlayer(game.GetPlayer(model::Map::Id{map_id}, model::Dog::Id{record.dog_id}), record.direction);
+        break;
+    }
+    case RecordType::TICK:
+        game.Tick(reader.Read<TickRecord>().milliseconds);
+        break;
+    case RecordType::LEAVE:
+        if (!game.RemovePlayer(reader.Read<LeaveRecord>().token)) {
+            throw std::runtime_error("Journal removes an unknown player"s);
+        }
+        break;
+    default:
+        throw std::runtime_error("Unknown journal record"s);
+    }
+}
+
+} // namespace
+
+Journal::Journal(boost::asio::io_context &ioc, std::filesystem::path path, std::uint64_t epoch)
+    : ioc_(ioc), path_(std::move(path)), epoch_(epoch) {
+    DropCovered(epoch_);
+    Open(epoch_);
+}
+
+Journal::~Journal() {
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+}
+
+void Journal::OnJoin(const model::Player &player, model::Token token) {
+    const auto &session = player.GetSession();
+    const auto &map_id = *session.GetMap().GetId();
+
+    util::BinaryWriter record;
+    const auto size = sizeof(JoinRecord) + map_id.size() + player.GetName().size();
+    record.Write(RecordHeader{RecordType::JOIN, static_cast<std::uint32_t>(size)});
+    record.Write(JoinRecord{*player.GetId(), token, session.GetDogStore().GetState(player.GetDog().GetIndex()),
+                            static_cast<std::uint32_t>(session.GetInstance()),
+                            static_cast<std::uint32_t>(map_id.size()),
+                            static_cast<std::uint32_t>(player.GetName().size())});
+    record.Write(std::string_view{map_id});
+    record.Write(player.GetName());
+    Append(std::move(record));
+}
+
+void Journal::OnAction(const model::Player &player, model::Direction direction) {
+    const auto &map_id = *player.GetSession().GetMap().GetId();
+
+    util::BinaryWriter record;
+    record.Write(RecordHeader{RecordType::ACTION, static_cast<std::uint32_t>(sizeof(ActionRecord) + map_id.size())});
+    record.Write(ActionRecord{*player.GetId(), direction, static_cast<std::uint32_t>(map_id.size())});
+    record.Write(std::string_view{map_id});
+    Append(std::move(record));
+}
+
+void Journal::OnLeave(const model::Player &, model::Token token) {
+    util::BinaryWriter record;
+    record.Write(RecordHeader{RecordType::LEAVE, sizeof(LeaveRecord)});
+    record.Write(LeaveRecord{token});
+    Append(std::move(record));
+}
+
+void Journal::OnTick(double milliseconds, bool idle) {
+    if (!idle) {
+        util::BinaryWriter record;
+        record.Write(RecordHeader{RecordType::TICK, sizeof(TickRecord)});
+        record.Write(TickRecord{milliseconds});
+        Append(std::move(record));
+    }
+    // Records made since the last tick are synced even if the tick is idle
+    Commit();
+}
+
+void Journal::Commit() {
+    if (buffer_.Size() == 0) {
+        return;
+    }
+    {
+        std::lock_guard lock{pending_mutex_};
+        pending_.append(buffer_.Take());
+    }
+    boost::asio::post(ioc_, [self = shared_from_this()] {
+        try {
+            self->Drain();
+        } catch (const std::exception &ex) {
+            util::LogError(EXIT_FAILURE, ex.what(), "journal"sv);
+        }
+    });
+}
+
+std::uint64_t Journal::Rotate() {
+    {
+        std::lock_guard lock{pending_mutex_};
+        pending_.append(buffer_.Take());
+    }
+    Drain();
+
+    // The name of the file is unique to its epoch, so the journals of the snapshots that failed to save are kept
+    std::lock_guard lock{file_mutex_};
+    ::close(std::exchange(fd_, -1));
+    std::filesystem::rename(path_, GetEpochPath(path_, epoch_));
+    Open(++epoch_);
+    return epoch_;
+}
+
+void Journal::DropCovered(std::uint64_t epoch) {
+    for (const auto &[file_epoch, file_path] : FindEpochFiles(path_)) {
+        if (file_epoch < epoch) {
+            std::filesystem::remove(file_path);
+        }
+    }
+}
+
+void Journal::Append(util::BinaryWriter &&record) {
+    if (buffer_.Size() == 0) {
+        buffer_ = std::move(record);
+    } else {
+        buffer_.Write(record.GetData());
+    }
+    if (buffer_.Size() >= commit_size) {
+        Commit();
+    }
+}
+
+void Journal::Drain() {
+    std::lock_guard file_lock{file_mutex_};
+    std::string data;
+    {
+        std::lock_guard lock{pending_mutex_};
+        data.swap(pending_);
+    }
+    if (data.empty()) {
+        return;
+    }
+    WriteAll(fd_, data);
+    Sync(fd_);
+}
+
+void Journal::Open(std::uint64_t epoch) {
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ == -1) {
+        throw std::system_error(errno, std::generic_category(), "Failed to open "s + path_.string());
+    }
+
+    util::BinaryWriter header;
+    header.Write(FileHeader{magic, version, game_snapshot::format_flags, epoch});
+    WriteAll(fd_, header.GetData());
+    Sync(fd_);
+}
+
+ReplayResult Replay(model::Game &game, const std::filesystem::path &path, std::uint64_t epoch) {
+    ReplayResult result;
+    std::vector<std::filesystem::path> file_paths;
+    for (auto &[file_epoch, file_path] : FindEpochFiles(path)) {
+        if (file_epoch >= epoch) {
+            file_paths.push_back(std::move(file_path));
+        }
+    }
+    file_paths.push_back(path);
+
+    for (const auto &file_path : file_paths) {
+        if (!std::filesystem::exists(file_path)) {
+            continue;
+        }
+
+        util::MappedFile file{file_path};
+        auto reader = file.GetReader();
+        // The server has stopped before the header was written
+        if (reader.Remaining() < sizeof(FileHeader)) {
+            continue;
+        }
+        const auto header = reader.Read<FileHeader>();
+        if (header.magic != magic || header.version != version) {
+            throw std::runtime_error(file_path.string() + " is not a game journal"s);
+        }
+        if (header.flags != game_snapshot::format_flags) {
+            throw std::runtime_error("Journal was written with another coordinate mode"s);
+        }
+        // The changes are already in the snapshot
+        if (header.epoch < epoch) {
+            continue;
+        }
+        result.last_epoch = std::max(result.last_epoch, header.epoch);
+
+        while (reader.Remaining() >= sizeof(RecordHeader)) {
+            const auto record = reader.Read<RecordHeader>();
+            // The last record has been written partially
+            if (record.type == RecordType::NONE || record.size > reader.Remaining()) {
+                break;
+            }
+            auto payload = reader.Sub(record.size);
+            Apply(game, record.type, payload);
+            ++result.records;
+        }
+    }
+    return result;
+}
+
+} // namespace game_journal
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "model/model.hpp"
+#include "util/binary_io.hpp"
+
+namespace game_journal {
+
+// Append-only log of the joins, actions, leaves and ticks made after the last snapshot.
+// Records are buffered on api_strand and written with a single fdatasync per tick (group commit),
+// so a crash loses at most the changes of the last tick period. Idle ticks change nothing and aren't recorded,
+// a tick without records costs no write at all.
+// Every snapshot starts a new epoch: the journals of the earlier ones are kept until a snapshot covering them is saved
+class Journal : public model::GameListener, public std::enable_shared_from_this<Journal> {
+  public:
+    // Starts the journal of the epoch, the files of earlier epochs are removed
+    Journal(boost::asio::io_context &ioc, std::filesystem::path path, std::uint64_t epoch);
+    ~Journal();
+
+    Journal(const Journal &) = delete;
+    Journal &operator=(const Journal &) = delete;
+
+    void OnJoin(const model::Player &player, model::Token token) override;
+    void OnAction(const model::Player &player, model::Direction direction) override;
+    void OnLeave(const model::Player &player, model::Token token) override;
+    void OnTick(double milliseconds, bool idle) override;
+
+    // Writes the buffered records in the background
+    void Commit();
+
+    // Writes the buffered records and starts the next epoch on the calling thread, returns the new epoch.
+    // Must be called on api_strand together with capturing the snapshot
+    std::uint64_t Rotate();
+
+    // Removes the journals of the epochs before the given one once a snapshot of that epoch has been saved
+    void DropCovered(std::uint64_t epoch);
+
+  private:
+    void Append(util::BinaryWriter &&record);
+    void Drain();
+    void Open(std::uint64_t epoch);
+
+    boost::asio::io_context &ioc_;
+    std::filesystem::path path_;
+
+    // Accessed on api_strand only
+    util::BinaryWriter buffer_;
+    std::uint64_t epoch_;
+
+    std::mutex pending_mutex_;
+    std::string pending_;
+
+    std::mutex file_mutex_;
+    int fd_ = -1;
+};
+
+struct ReplayResult {
+    std::size_t records = 0;
+    std::uint64_t last_epoch = 0;
+};
+
+// Applies the journals of the epoch and later to the restored game. A truncated last record is ignored
+ReplayResult Replay(model::Game &game, const std::filesystem::path &path, std::uint64_t epoch);
+
+} // namespace game_journal
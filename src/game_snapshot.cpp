@@ -0,0 +1,202 @@
+#include "game_snapshot.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "util/binary_io.hpp"
+
+namespace game_snapshot {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::array<char, 8> magic{'D', 'O', 'G', 'S', 'N', 'A', 'P', '\0'};
+constexpr std::uint32_t version = 6;
+
+struct Header {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t journal_epoch;
+    std::uint64_t token_nonce;
+    std::uint64_t session_count;
+    std::uint64_t player_count;
+};
+
+// Followed by map id
+struct SessionHeader {
+    std::uint32_t instance;
+    std::uint32_t map_id_size;
+    std::uint64_t roads_hash;
+};
+
+// Fixed part of a player record, followed by map id and name
+struct PlayerHeader {
+    std::uint64_t dog_id;
+    model::Token token;
+    model::DogStore::DogState state;
+    std::uint32_t instance;
+    std::uint32_t map_id_size;
+    std::uint32_t name_size;
+};
+
+// Closes the descriptor when the file is done with
+class FileDescriptor {
+  public:
+    FileDescriptor(const std::filesystem::path &path, int flags, mode_t mode = 0)
+        : fd_(::open(path.c_str(), flags | O_CLOEXEC, mode)) {
+        if (fd_ == -1) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open "s + path.string());
+        }
+    }
+    ~FileDescriptor() {
+        if (fd_ != -1) {
+            ::close(fd_);
+        }
+    }
+
+    FileDescriptor(const FileDescriptor &) = delete;
+    FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+    void Write(std::string_view data, const std::filesystem::path &path) {
+        while (!data.empty()) {
+            const auto written = ::write(fd_, data.data(), data.size());
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "Failed to write "s + path.string());
+            }
+            data.remove_prefix(written);
+        }
+    }
+
+    void Sync(const std::filesystem::path &path) {
+        if (::fsync(fd_) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to sync "s + path.string());
+        }
+    }
+
+    // A failed close may be the only report of a failed write
+    void Close(const std::filesystem::path &path) {
+        if (::close(std::exchange(fd_, -1)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to close "s + path.string());
+        }
+    }
+
+  private:
+    int fd_;
+};
+
+// FNV-1a of the roads in their order
+std::uint64_t HashRoads(const model::Map &map) {
+    std::uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](std::int64_t value) {
+        for (int i = 0; i < 8; ++i, value >>= 8) {
+            hash = (hash ^ (value & 0xff)) * 1099511628211ull;
+        }
+    };
+    for (const auto &road : map.GetRoads()) {
+        add(road.GetStart().x);
+        add(road.GetStart().y);
+        add(road.GetEnd().x);
+        add(road.GetEnd().y);
+    }
+    return hash;
+}
+
+} // namespace
+
+Snapshot Capture(const model::Game &game) {
+    Snapshot snapshot;
+    if (const auto *signer = game.GetTokenSigner()) {
+        snapshot.token_nonce = signer->GetNonce();
+    }
+    game.ForEachSession([&snapshot](const model::GameSession &session) {
+        snapshot.sessions.push_back({*session.GetMap().GetId(), session.GetInstance(), HashRoads(session.GetMap())});
+    });
+    game.ForEachPlayer([&snapshot](model::Token token, const model::Player &player) {
+        const auto &session = player.GetSession();
+        snapshot.players.push_back({*session.GetMap().GetId(), session.GetInstance(), *player.GetId(),
+                                    std::string(player.GetName()), token,
+                                    session.GetDogStore().GetState(player.GetDog().GetIndex())});
+    });
+    return snapshot;
+}
+
+void Save(const Snapshot &snapshot, const std::filesystem::path &path) {
+    util::BinaryWriter writer;
+    writer.Write(Header{magic, version, format_flags, snapshot.journal_epoch, snapshot.token_nonce,
+                        snapshot.sessions.size(), snapshot.players.size()});
+    for (const auto &session : snapshot.sessions) {
+        writer.Write(SessionHeader{static_cast<std::uint32_t>(session.instance),
+                                   static_cast<std::uint32_t>(session.map_id.size()), session.roads_hash});
+        writer.Write(std::string_view{session.map_id});
+    }
+    for (const auto &player : snapshot.players) {
+        writer.Write(PlayerHeader{player.dog_id, player.token, player.state,
+                                  static_cast<std::uint32_t>(player.instance),
+                                  static_cast<std::uint32_t>(player.map_id.size()),
+                                  static_cast<std::uint32_t>(player.name.size())});
+        writer.Write(std::string_view{player.map_id});
+        writer.Write(std::string_view{player.name});
+    }
+
+    // The data reaches the disk before the rename, and the rename before the function returns,
+    // so after a crash the file is either the previous snapshot or this one
+    auto temp_path = path;
+    temp_path += ".tmp";
+    FileDescriptor file{temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644};
+    file.Write(writer.GetData(), temp_path);
+    file.Sync(temp_path);
+    file.Close(temp_path);
+
+    std::filesystem::rename(temp_path, path);
+
+    const auto directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path{"."};
+    FileDescriptor directory_file{directory, O_RDONLY | O_DIRECTORY};
+    directory_file.Sync(directory);
+}
+
+std::uint64_t Restore(model::Game &game, const std::filesystem::path &path) {
+    util::MappedFile file{path};
+    auto reader = file.GetReader();
+
+    const auto header = reader.Read<Header>();
+    if (header.magic != magic || header.version != version) {
+        throw std::runtime_error(path.string() + " is not a game snapshot"s);
+    }
+    if (header.flags != format_flags) {
+        throw std::runtime_error("Snapshot was saved with another coordinate mode"s);
+    }
+    if (header.token_nonce != 0) {
+        game.RestoreTokenNonce(header.token_nonce);
+    }
+
+    // Sessions are created first, in their original order
+    for (std::uint64_t i = 0; i < header.session_count; ++i) {
+        const auto session = reader.Read<SessionHeader>();
+        const auto map_id = reader.ReadString(session.map_id_size);
+        const auto &restored = game.RestoreSession(model::Map::Id{map_id}, session.instance);
+        if (HashRoads(restored.GetMap()) != session.roads_hash) {
+            throw std::runtime_error("Roads of the map "s + map_id + " have changed since the snapshot was saved"s);
+        }
+    }
+    for (std::uint64_t i = 0; i < header.player_count; ++i) {
+        const auto player = reader.Read<PlayerHeader>();
+        auto map_id = reader.ReadString(player.map_id_size);
+        auto name = reader.ReadString(player.name_size);
+        game.RestorePlayer(model::Map::Id{std::move(map_id)}, player.instance, model::Dog::Id{player.dog_id},
+                           std::move(name), player.token, player.state);
+    }
+    return header.journal_epoch;
+}
+
+} // namespace game_snapshot
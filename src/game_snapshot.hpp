@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "model/model.hpp"
+
+namespace game_snapshot {
+
+// Snapshots and journals store coordinates as is, so they can't be read by a build with another coordinate mode
+enum FormatFlags : std::uint32_t {
+    FIXED_POINT = 1,
+};
+
+#ifdef FIXED_POINT_COORDINATES
+inline constexpr std::uint32_t format_flags = FIXED_POINT;
+#else
+inline constexpr std::uint32_t format_flags = 0;
+#endif
+
+struct SessionRecord {
+    std::string map_id;
+    std::size_t instance;
+    // Dogs refer to the roads of the map by index, so the snapshot is restored only with the same roads
+    std::uint64_t roads_hash;
+};
+
+struct PlayerRecord {
+    std::string map_id;
+    std::size_t instance;
+    std::size_t dog_id;
+    std::string name;
+    model::Token token;
+    model::DogStore::DogState state;
+};
+
+// Plain copy of the game state which can be written while the game keeps running
+struct Snapshot {
+    std::vector<SessionRecord> sessions;
+    std::vector<PlayerRecord> players;
+    // Journals of this epoch and later contain the changes made after the snapshot
+    std::uint64_t journal_epoch = 0;
+    // Nonce of the signed tokens, zero if tokens are random
+    std::uint64_t token_nonce = 0;
+};
+
+// Must be called where the game isn't modified concurrently (on api_strand)
+Snapshot Capture(const model::Game &game);
+
+// Write the snapshot to a temporary file and atomically replace the previous one.
+// Returns once the snapshot is on the disk; throws std::system_error otherwise
+void Save(const Snapshot &snapshot, const std::filesystem::path &path);
+
+// Map the snapshot file into memory and recreate its sessions and players in the game.
+// Returns the journal epoch of the snapshot
+std::uint64_t Restore(model::Game &game, const std::filesystem::path &path);
+
+} // namespace game_snapshot
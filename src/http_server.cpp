@@ -1,7 +1,10 @@
 #include "http_server.hpp"
 #include "util/logging.hpp"
 
-#include <boost/asio/dispatch.hpp>
+#include <sys/sendfile.h>
+
+#include <algorithm>
+#include <cerrno>
 
 namespace http_server {
 
@@ -9,8 +12,52 @@ using namespace util;
 
 void ReportError(beast::error_code ec, std::string_view what) { LogError(ec.value(), ec.message(), what); }
 
+std::optional<ConnectionLimiter::Slot> ConnectionLimiter::TryAcquire(const net::ip::address &address) {
+    if (!limits_.max_connections && !limits_.max_connections_per_ip) {
+        return Slot{};
+    }
+
+    std::lock_guard lock{mutex_};
+    auto &count = per_address_[address];
+    if ((limits_.max_connections && total_ >= *limits_.max_connections) ||
+        (limits_.max_connections_per_ip && count >= *limits_.max_connections_per_ip)) {
+        if (count == 0) {
+            per_address_.erase(address);
+        }
+        return std::nullopt;
+    }
+    ++total_;
+    ++count;
+    return Slot{shared_from_this(), address};
+}
+
+void ConnectionLimiter::Release(const net::ip::address &address) {
+    std::lock_guard lock{mutex_};
+    --total_;
+    if (auto it = per_address_.find(address); --it->second == 0) {
+        per_address_.erase(it);
+    }
+}
+
+void RejectConnection(tcp::socket &&socket) {
+    static constexpr std::string_view response = "HTTP/1.1 503 Service Unavailable\r\n"
+                                                 "Retry-After: 1\r\n"
+                                                 "Content-Length: 0\r\n"
+                                                 "Connection: close\r\n\r\n"sv;
+
+    auto safe_socket = std::make_shared<tcp::socket>(std::move(socket));
+    net::async_write(*safe_socket, net::buffer(response), [safe_socket](beast::error_code, std::size_t) {
+        beast::error_code ec;
+        safe_socket->shutdown(tcp::socket::shutdown_send, ec);
+    });
+}
+
 void SessionBase::Read() {
     using namespace std::literals;
+    if (reading_ || read_finished_ || pending_.size() >= max_pipelined_requests) {
+        return;
+    }
+    reading_ = true;
     // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз)
     request_ = {};
     stream_.expires_after(30s);
@@ -28,30 +75,123 @@ void SessionBase::Run() {
 
 void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
     using namespace std::literals;
+    reading_ = false;
     if (ec == http::error::end_of_stream) {
-        // Нормальная ситуация - клиент закрыл соединение
-        return Close();
+        // Нормальная ситуация - клиент закрыл соединение; ответы на прочитанные запросы ещё отправляются
+        read_finished_ = true;
+        if (pending_.empty()) {
+            Close();
+        }
+        return;
     }
     if (ec) {
+        read_finished_ = true;
         return ReportError(ec, "read"sv);
     }
-    HandleRequest(std::move(request_));
+
+    std::unique_ptr<util::RequestArena> arena;
+    if (free_arenas_.empty()) {
+        arena = std::make_unique<util::RequestArena>();
+    } else {
+        arena = std::move(free_arenas_.back());
+        free_arenas_.pop_back();
+        arena->Reset();
+    }
+    auto &pending = pending_.emplace_back(Pending{std::move(arena), {}});
+    const Sequence sequence = first_pending_ + pending_.size() - 1;
+
+    // После ответа на такой запрос соединение будет закрыто, следующие не читаем
+    read_finished_ = !request_.keep_alive();
+    HandleRequest(std::move(request_), *pending.arena, sequence);
+    Read();
+}
+
+void SessionBase::Enqueue(Sequence sequence, std::function<void()> write) {
+    pending_[sequence - first_pending_].write = std::move(write);
+    WriteNext();
+}
+
+void SessionBase::WriteNext() {
+    if (!writing_ && !pending_.empty() && pending_.front().write) {
+        writing_ = true;
+        pending_.front().write();
+    }
 }
 
 void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    writing_ = false;
     if (ec) {
         return ReportError(ec, "write"sv);
     }
 
     if (close) {
-        // Семантика ответа требует закрыть соединение
+        // Семантика ответа требует закрыть соединение, ответы на следующие запросы не отправляются
         return Close();
     }
 
-    // Считываем следующий запрос
+    free_arenas_.push_back(std::move(pending_.front().arena));
+    pending_.pop_front();
+    ++first_pending_;
+
+    if (read_finished_ && pending_.empty()) {
+        return Close();
+    }
+    WriteNext();
+    // Освободилось место для следующего запроса
     Read();
 }
 
+void SessionBase::WriteFile(std::shared_ptr<FileResponse> response) {
+    auto serializer = std::make_shared<http::response_serializer<http::file_body>>(*response);
+    http::async_write_header(stream_, *serializer,
+                             [self = GetSharedThis(), response, serializer](beast::error_code ec, std::size_t bytes) {
+                                 if (ec) {
+                                     return self->OnWrite(response->need_eof(), ec, bytes);
+                                 }
+                                 self->SendFile(std::move(response), 0);
+                             });
+}
+
+void SessionBase::SendFile(std::shared_ptr<FileResponse> response, std::uint64_t offset) {
+    // A single call sends at most this much, so that a fast client doesn't hold the executor for a long time
+    constexpr std::uint64_t max_chunk = 1 << 20;
+
+    auto &socket = stream_.socket();
+    beast::error_code ec;
+    socket.native_non_blocking(true, ec);
+    const int file = response->body().file().native_handle();
+    const auto size = response->body().size();
+
+    while (!ec && offset < size) {
+        off_t file_offset = static_cast<off_t>(offset);
+        const auto sent = ::sendfile(socket.native_handle(), file, &file_offset, std::min(size - offset, max_chunk));
+        if (sent > 0) {
+            offset += sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Буфер сокета заполнен, продолжаем, когда в него снова можно писать
+            return socket.async_wait(tcp::socket::wait_write,
+                                     [self = GetSharedThis(), response, offset](beast::error_code ec) mutable {
+                                         if (ec) {
+                                             return self->OnWrite(true, ec, offset);
+                                         }
+                                         self->SendFile(std::move(response), offset);
+                                     });
+        } else if (sent == 0) {
+            // The file has been truncated since the header was written, the promised length can't be sent
+            ec = net::error::eof;
+        } else {
+            ec.assign(errno, sys::system_category());
+        }
+    }
+    if (ec) {
+        // The client would otherwise wait for the rest of the body until the read timeout
+        Close();
+    }
+    OnWrite(response->need_eof(), ec, offset);
+}
+
 void SessionBase::Close() {
     beast::error_code ec;
     stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
@@ -1,10 +1,24 @@
 #pragma once
 
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "util/request_arena.hpp"
 
 // Ядро асинхронного HTTP-сервера будет располагаться в пространстве имён http_server
 namespace http_server {
@@ -19,25 +33,87 @@ using namespace std::literals;
 
 void ReportError(beast::error_code ec, std::string_view what);
 
+// Counts open connections in total and per client address
+class ConnectionLimiter : public std::enable_shared_from_this<ConnectionLimiter> {
+  public:
+    struct Limits {
+        std::optional<std::size_t> max_connections;
+        std::optional<std::size_t> max_connections_per_ip;
+    };
+
+    // Keeps the connection counted until it is destroyed
+    class Slot {
+      public:
+        Slot() = default;
+        Slot(std::shared_ptr<ConnectionLimiter> limiter, net::ip::address address)
+            : limiter_(std::move(limiter)), address_(std::move(address)) {}
+
+        Slot(Slot &&) = default;
+        Slot &operator=(Slot &&) = default;
+
+        ~Slot() {
+            if (limiter_) {
+                limiter_->Release(address_);
+            }
+        }
+
+      private:
+        std::shared_ptr<ConnectionLimiter> limiter_;
+        net::ip::address address_;
+    };
+
+    explicit ConnectionLimiter(Limits limits) : limits_(limits) {}
+
+    // Empty if the connection would exceed a limit
+    std::optional<Slot> TryAcquire(const net::ip::address &address);
+
+  private:
+    void Release(const net::ip::address &address);
+
+    Limits limits_;
+    std::mutex mutex_;
+    std::size_t total_ = 0;
+    std::map<net::ip::address, std::size_t> per_address_;
+};
+
+// Answers 503 to a connection over the limits and closes it without reading the request
+void RejectConnection(tcp::socket &&socket);
+
+// Requests of a connection are read ahead while earlier ones are handled (HTTP/1.1 pipelining),
+// responses are written in the order of the requests
 class SessionBase {
   protected:
     using HttpRequest = http::request<http::string_body>;
+    // Number of the request in the connection
+    using Sequence = std::uint64_t;
 
-    explicit SessionBase(tcp::socket &&socket) : stream_(std::move(socket)) {}
+    // Requests of a connection handled at once; the next one is read when the oldest response is written
+    static constexpr std::size_t max_pipelined_requests = 8;
+
+    SessionBase(tcp::socket &&socket, ConnectionLimiter::Slot slot)
+        : stream_(std::move(socket)), slot_(std::move(slot)) {}
     ~SessionBase() = default;
 
     void Read();
 
+    // May be called from any thread, the response is queued on the executor of the stream
     template <typename Body, typename Fields>
-    void Write(http::response<Body, Fields> &&response) {
+    void Write(Sequence sequence, http::response<Body, Fields> &&response) {
         // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
         auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
 
-        auto self = GetSharedThis();
-        http::async_write(stream_, *safe_response,
-                          [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-                              self->OnWrite(safe_response->need_eof(), ec, bytes_written);
-                          });
+        net::dispatch(stream_.get_executor(), [self = GetSharedThis(), sequence, safe_response] {
+            self->Enqueue(sequence, [self, safe_response] {
+                if constexpr (std::is_same_v<http::response<Body, Fields>, FileResponse>) {
+                    self->WriteFile(safe_response);
+                } else {
+                    http::async_write(self->stream_, *safe_response,
+                                      [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
+                                          self->OnWrite(safe_response->need_eof(), ec, bytes_written);
+                                      });
+                }
+            });
+        });
     }
 
     // tcp_stream содержит внутри себя сокет и добавляет поддержку таймаутов
@@ -51,35 +127,63 @@ class SessionBase {
     void Run();
 
   private:
+    using FileResponse = http::response<http::file_body>;
+
+    // Request waiting for its response or for the responses of the earlier requests
+    struct Pending {
+        // Memory for the JSON documents of the request, reset when the slot is reused
+        std::unique_ptr<util::RequestArena> arena;
+        // Starts writing the response, empty until the response is ready
+        std::function<void()> write;
+    };
+
     void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
+    void Enqueue(Sequence sequence, std::function<void()> write);
+    void WriteNext();
     void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
+    // The header of a file response is written by Beast, the body is sent by sendfile from the offset on
+    void WriteFile(std::shared_ptr<FileResponse> response);
+    void SendFile(std::shared_ptr<FileResponse> response, std::uint64_t offset);
     void Close();
 
     // Обработку запроса делегируем подклассу
-    virtual void HandleRequest(HttpRequest &&request) = 0;
+    virtual void HandleRequest(HttpRequest &&request, util::RequestArena &arena, Sequence sequence) = 0;
     virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
 
+    ConnectionLimiter::Slot slot_;
     beast::flat_buffer buffer_;
     HttpRequest request_;
+
+    // Requests from the oldest one whose response hasn't been written yet
+    std::deque<Pending> pending_;
+    Sequence first_pending_ = 0;
+    // Arenas of the written requests kept for the next ones
+    std::vector<std::unique_ptr<util::RequestArena>> free_arenas_;
+    bool reading_ = false;
+    bool writing_ = false;
+    // The client closed its side or the connection failed, no more requests will be read
+    bool read_finished_ = false;
 };
 
 template <typename RequestHandler>
 class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
   public:
     template <typename Handler>
-    Session(tcp::socket &&socket, Handler &&request_handler)
-        : SessionBase(std::move(socket)), request_handler_(std::forward<Handler>(request_handler)) {}
+    Session(tcp::socket &&socket, ConnectionLimiter::Slot slot, Handler &&request_handler)
+        : SessionBase(std::move(socket), std::move(slot)), request_handler_(std::forward<Handler>(request_handler)) {}
 
   private:
     std::shared_ptr<SessionBase> GetSharedThis() override { return this->shared_from_this(); }
 
-    void HandleRequest(HttpRequest &&request) override {
+    void HandleRequest(HttpRequest &&request, util::RequestArena &arena, Sequence sequence) override {
         // Захватываем умный указатель на текущий объект Session в лямбде,
         // чтобы продлить время жизни сессии до вызова лямбды.
         // Используется generic-лямбда функция, способная принять response произвольного типа
-        request_handler_(stream_.socket().remote_endpoint().address().to_string(), std::move(request),
-                         [self = this->shared_from_this()]<typename Body, typename Fields>(
-                             http::response<Body, Fields> &&response) { self->Write(std::move(response)); });
+        request_handler_(stream_.socket().remote_endpoint().address().to_string(), std::move(request), arena,
+                         [self = this->shared_from_this(), sequence]<typename Body, typename Fields>(
+                             http::response<Body, Fields> &&response) {
+                             self->Write(sequence, std::move(response));
+                         });
     }
 
     RequestHandler request_handler_;
@@ -89,11 +193,13 @@ template <typename RequestHandler>
 class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
   public:
     template <typename Handler>
-    Listener(net::io_context &ioc, const tcp::endpoint &endpoint, Handler &&request_handler)
+    Listener(net::io_context &ioc, const tcp::endpoint &endpoint, Handler &&request_handler,
+             ConnectionLimiter::Limits limits = {})
         : ioc_(ioc)
           // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
           ,
-          acceptor_(net::make_strand(ioc)), request_handler_(std::forward<Handler>(request_handler)) {
+          acceptor_(net::make_strand(ioc)), request_handler_(std::forward<Handler>(request_handler)),
+          limiter_(std::make_shared<ConnectionLimiter>(limits)) {
         // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
         acceptor_.open(endpoint.protocol());
 
@@ -135,28 +241,39 @@ class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
             return ReportError(ec, "accept"sv);
         }
 
-        // Асинхронно обрабатываем сессию
-        AsyncRunSession(std::move(socket));
+        // Соединения сверх лимитов сразу получают отказ, чтобы не отнимать время у принятых
+        sys::error_code endpoint_ec;
+        const auto endpoint = socket.remote_endpoint(endpoint_ec);
+        if (!endpoint_ec) {
+            if (auto slot = limiter_->TryAcquire(endpoint.address())) {
+                // Асинхронно обрабатываем сессию
+                AsyncRunSession(std::move(socket), std::move(*slot));
+            } else {
+                RejectConnection(std::move(socket));
+            }
+        }
 
         // Принимаем новое соединение
         DoAccept();
     }
 
-    void AsyncRunSession(tcp::socket &&socket) {
-        std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_)->Run();
+    void AsyncRunSession(tcp::socket &&socket, ConnectionLimiter::Slot slot) {
+        std::make_shared<Session<RequestHandler>>(std::move(socket), std::move(slot), request_handler_)->Run();
     }
 
     net::io_context &ioc_;
     tcp::acceptor acceptor_;
     RequestHandler request_handler_;
+    std::shared_ptr<ConnectionLimiter> limiter_;
 };
 
 template <typename RequestHandler>
-void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint, RequestHandler &&handler) {
+void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint, RequestHandler &&handler,
+               ConnectionLimiter::Limits limits = {}) {
     // При помощи decay_t исключим ссылки из типа RequestHandler,
     // чтобы Listener хранил RequestHandler по значению
     using MyListener = Listener<std::decay_t<RequestHandler>>;
-    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler), limits)->Run();
 }
 
 } // namespace http_server
\ No newline at end of file
@@ -9,16 +9,23 @@
 
 #include <boost/program_options.hpp>
 
+#include <atomic>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <optional>
 #include <thread>
 
+#include "game_journal.hpp"
+#include "game_snapshot.hpp"
 #include "http_server.hpp"
 #include "json_loader.hpp"
 #include "request_handler.hpp"
 #include "util/logging.hpp"
 #include "util/ticker.hpp"
+#include "util/worker_pool.hpp"
 
 using namespace std::literals;
 using namespace util;
@@ -41,6 +48,19 @@ void RunWorkers(unsigned num_threads, const Fn &fn) {
     fn();
 }
 
+// Ключ подписи токенов — содержимое файла без завершающего перевода строки
+std::string ReadTokenKey(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::string key{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    while (!key.empty() && (key.back() == '\n' || key.back() == '\r')) {
+        key.pop_back();
+    }
+    if (!file || key.empty()) {
+        throw std::runtime_error("Failed to read token key from "s + path.string());
+    }
+    return key;
+}
+
 } // namespace
 
 struct Args {
@@ -48,6 +68,14 @@ struct Args {
     std::string config_file;
     std::string www_root;
     bool randomize_spawn_points{false};
+    std::optional<std::uint64_t> random_seed;
+    std::optional<std::string> state_file;
+    std::optional<int> save_state_period;
+    std::optional<std::string> journal_file;
+    std::optional<std::string> token_key_file;
+    std::optional<int> coordinate_precision;
+    http_server::ConnectionLimiter::Limits connection_limits;
+    util::QueueBudget::Limits api_limits;
 };
 
 [[nodiscard]]
@@ -59,12 +87,36 @@ std::optional<Args> ParseCommandLine(int argc, const char *const argv[]) {
     Args args;
     // clang-format off
     int tick_period;
+    std::uint64_t random_seed;
+    std::string state_file;
+    int save_state_period;
+    std::string journal_file;
+    std::string token_key_file;
+    int coordinate_precision;
+    std::size_t max_connections;
+    std::size_t max_connections_per_ip;
+    std::size_t api_queue_depth;
+    int api_queue_delay;
     desc.add_options()
         ("help,h", "Show help")
         ("tick-period,t", po::value(&tick_period)->value_name("milliseconds"s), "set tick period")
         ("config-file,c", po::value(&args.config_file)->value_name("file"), "set config file path")
         ("www-root,w", po::value(&args.www_root)->value_name("dir"), "set static files root")
-        ("randomize-spawn-points", po::bool_switch(&args.randomize_spawn_points), "spawn dogs at random positions");
+        ("randomize-spawn-points", po::bool_switch(&args.randomize_spawn_points), "spawn dogs at random positions")
+        ("random-seed", po::value(&random_seed)->value_name("seed"), "seed random generators for reproducible runs")
+        ("state-file", po::value(&state_file)->value_name("file"), "set game state file path")
+        ("save-state-period", po::value(&save_state_period)->value_name("milliseconds"), "set state saving period")
+        ("journal-file", po::value(&journal_file)->value_name("file"), "journal changes made between state savings")
+        ("token-key-file", po::value(&token_key_file)->value_name("file"), "issue tokens signed with the key")
+        ("coordinate-precision", po::value(&coordinate_precision)->value_name("digits"),
+            "write coordinates in responses with fixed digits after the point")
+        ("max-connections", po::value(&max_connections)->value_name("count"), "limit open connections")
+        ("max-connections-per-ip", po::value(&max_connections_per_ip)->value_name("count"),
+            "limit open connections of a client address")
+        ("api-queue-depth", po::value(&api_queue_depth)->value_name("count"),
+            "refuse API requests when this many are waiting")
+        ("api-queue-delay", po::value(&api_queue_delay)->value_name("milliseconds"),
+            "refuse API requests when they wait longer than this");
     // clang-format on
 
     // variables_map хранит значения опций после разбора
@@ -82,6 +134,52 @@ std::optional<Args> ParseCommandLine(int argc, const char *const argv[]) {
         args.tick_period = tick_period;
     }
 
+    if (vm.contains("random-seed")) {
+        args.random_seed = random_seed;
+    }
+
+    if (vm.contains("state-file")) {
+        args.state_file = state_file;
+    }
+
+    if (vm.contains("save-state-period")) {
+        args.save_state_period = save_state_period;
+    }
+
+    if (vm.contains("journal-file")) {
+        if (!args.state_file) {
+            throw std::runtime_error{"Journal requires state file"s};
+        }
+        args.journal_file = journal_file;
+    }
+
+    if (vm.contains("token-key-file")) {
+        args.token_key_file = token_key_file;
+    }
+
+    if (vm.contains("coordinate-precision")) {
+        if (coordinate_precision < 0 || coordinate_precision > 17) {
+            throw std::runtime_error{"Coordinate precision must be from 0 to 17"s};
+        }
+        args.coordinate_precision = coordinate_precision;
+    }
+
+    if (vm.contains("max-connections")) {
+        args.connection_limits.max_connections = max_connections;
+    }
+
+    if (vm.contains("max-connections-per-ip")) {
+        args.connection_limits.max_connections_per_ip = max_connections_per_ip;
+    }
+
+    if (vm.contains("api-queue-depth")) {
+        args.api_limits.max_depth = api_queue_depth;
+    }
+
+    if (vm.contains("api-queue-delay")) {
+        args.api_limits.max_delay = std::chrono::milliseconds{api_queue_delay};
+    }
+
     if (!vm.contains("config-file")) {
         throw std::runtime_error{"Config file has not been specified"s};
     }
@@ -121,30 +219,107 @@ int main(int argc, const char *argv[]) {
         // 3. Загружаем карту из файла и строим модель игры
         model::Game game = json_loader::LoadGame(args->config_file);
         game.SetRandomizeSpawnPoint(args->randomize_spawn_points);
+        if (args->random_seed) {
+            game.SetRandomSeed(*args->random_seed);
+        }
+        if (args->token_key_file) {
+            game.SetTokenKey(ReadTokenKey(*args->token_key_file));
+        }
+        if (args->coordinate_precision) {
+            game.SetCoordinatePrecision(*args->coordinate_precision);
+        }
+        // Тик выполняется на api_strand, который участвует в нём наравне с потоками пула
+        game.SetTickPool(std::make_shared<WorkerPool>(std::max(1u, num_threads) - 1));
+
+        // Восстанавливаем состояние игры, сохранённое при прошлом запуске, и применяем к нему журнал
+        std::uint64_t journal_epoch = 0;
+        if (args->state_file && std::filesystem::exists(*args->state_file)) {
+            journal_epoch = game_snapshot::Restore(game, *args->state_file);
+        }
+        std::shared_ptr<game_journal::Journal> journal;
+        if (args->journal_file) {
+            const auto replay_start = std::chrono::steady_clock::now();
+            const auto [records, last_epoch] = game_journal::Replay(game, *args->journal_file, journal_epoch);
+            const auto replay_time = std::chrono::steady_clock::now() - replay_start;
+            LogJournalReplayed(records, std::chrono::duration_cast<std::chrono::milliseconds>(replay_time).count());
+
+            // Восстановленное состояние сохраняется сразу, журнал начинается заново
+            auto snapshot = game_snapshot::Capture(game);
+            snapshot.journal_epoch = std::max(journal_epoch, last_epoch) + 1;
+            // Журнал удаляет файлы прежних эпох, поэтому создаётся только после сохранения снимка
+            game_snapshot::Save(snapshot, *args->state_file);
+            journal = std::make_shared<game_journal::Journal>(ioc, *args->journal_file, snapshot.journal_epoch);
+            game.SetListener(journal);
+        }
+        // Журнал начинает новую эпоху в момент копирования состояния
+        auto capture_state = [&game, &journal] {
+            auto snapshot = game_snapshot::Capture(game);
+            if (journal) {
+                snapshot.journal_epoch = journal->Rotate();
+            }
+            return snapshot;
+        };
+        // Журналы удаляются, только когда покрывающий их снимок уже на диске: Save возвращается после fsync
+        // и бросает исключение при ошибке
+        auto save_state = [&journal, path = args->state_file](const game_snapshot::Snapshot &snapshot) {
+            game_snapshot::Save(snapshot, *path);
+            if (journal) {
+                journal->DropCovered(snapshot.journal_epoch);
+            }
+        };
+
         if (args->tick_period) {
             game.SetTickPeriod(*args->tick_period);
-            Ticker ticker{api_strand, std::chrono::milliseconds{*args->tick_period},
-                          [tick_period = *args->tick_period, &game](std::chrono::milliseconds delta) {
-                              game.Tick(delta.count());
-                          }};
-            ticker.Start();
+            auto ticker = std::make_shared<Ticker>(
+                api_strand, std::chrono::milliseconds{*args->tick_period},
+                [&game](std::chrono::milliseconds delta) { game.Tick(delta.count()); });
+            ticker->Start();
+        }
+
+        // Состояние копируется на api_strand, а записывается в файл вне его
+        std::atomic_bool saving{false};
+        if (args->state_file && args->save_state_period) {
+            auto saver = std::make_shared<Ticker>(
+                api_strand, std::chrono::milliseconds{*args->save_state_period},
+                [&ioc, &saving, &capture_state, &save_state](std::chrono::milliseconds) {
+                    if (saving.exchange(true)) {
+                        return;
+                    }
+                    net::post(ioc, [&saving, &save_state, snapshot = capture_state()] {
+                        try {
+                            save_state(snapshot);
+                        } catch (const std::exception &ex) {
+                            LogError(EXIT_FAILURE, ex.what(), "save state"sv);
+                        }
+                        saving = false;
+                    });
+                });
+            saver->Start();
         }
 
         // 4. Создаём обработчик HTTP-запросов и связываем его с моделью игры
-        request_handler::RequestHandler handler{game, args->www_root, api_strand};
+        request_handler::RequestHandler handler{game, args->www_root, api_strand, args->api_limits};
 
         // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
         const auto address = net::ip::make_address("0.0.0.0");
         constexpr net::ip::port_type port = 8080;
-        http_server::ServeHttp(ioc, {address, port}, [&handler](auto &&addr, auto &&req, auto &&send) {
-            handler(std::forward<decltype(addr)>(addr), std::forward<decltype(req)>(req),
-                    std::forward<decltype(send)>(send));
-        });
+        http_server::ServeHttp(
+            ioc, {address, port},
+            [&handler](auto &&addr, auto &&req, auto &arena, auto &&send) {
+                handler(std::forward<decltype(addr)>(addr), std::forward<decltype(req)>(req), arena,
+                        std::forward<decltype(send)>(send));
+            },
+            args->connection_limits);
 
         // 6. Запускаем обработку асинхронных операций
         LogStart(address.to_string(), port);
         RunWorkers(std::max(1u, num_threads), [&ioc] { ioc.run(); });
 
+        // Все потоки остановлены, сохраняем итоговое состояние
+        if (args->state_file) {
+            save_state(capture_state());
+        }
+
         // Логирование успешного завершения программы
         LogExit(EXIT_SUCCESS);
 
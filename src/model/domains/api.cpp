@@ -1,4 +1,6 @@
 #include "api.hpp"
+#include <array>
+#include <charconv>
 #include <chrono>
 #include <string>
 
@@ -26,32 +28,79 @@ TickRequest tag_invoke(value_to_tag<TickRequest>, const value &value) {
 
 namespace api::responses {
 
-void tag_invoke(value_from_tag, value &value, const JoinResponse &response) {
-    value = {{"authToken", *response.authToken}, {"playerId", *response.playerId}};
+namespace {
+
+// Decimal form of the id without a temporary string
+class IdKey {
+  public:
+    explicit IdKey(Dog::Id id) noexcept : size_(std::to_chars(data_.begin(), data_.end(), *id).ptr - data_.data()) {}
+
+    operator std::string_view() const noexcept { return {data_.data(), size_}; }
+
+  private:
+    std::array<char, 20> data_;
+    std::size_t size_;
+};
+
+// Coordinates and speeds are written with the precision of the writer
+void WriteDogState(util::JsonWriter &writer, const GameSession &session, DogStore::Index index) {
+    const auto &store = session.GetDogStore();
+    auto [x, y] = store.GetPosition(index);
+    auto [dx, dy] = store.GetSpeed(index);
+    writer.Key(IdKey{session.GetDogId(index)}).BeginObject();
+    writer.Key("pos").BeginArray().Number(static_cast<double>(x)).Number(static_cast<double>(y)).EndArray();
+    writer.Key("speed").BeginArray().Number(static_cast<double>(dx)).Number(static_cast<double>(dy)).EndArray();
+    writer.Key("dir").String(serialize(store.GetDirection(index)));
+    writer.EndObject();
 }
 
-void tag_invoke(value_from_tag, value &value, const GetPlayersResponse &response) {
-    value = {};
-    auto &obj = value.as_object();
+// A dog takes about this many bytes of a state response
+constexpr std::size_t dog_state_size = 80;
+
+} // namespace
 
-    for (const auto &[key, value] : response.players) {
-        std::string ident = std::to_string(*value->GetId());
-        obj[ident] = {{"name", value->GetName()}};
+void WriteJson(util::JsonWriter &writer, const JoinResponse &response) {
+    const auto token = response.authToken.ToHex();
+    writer.BeginObject();
+    writer.Key("authToken").String({token.data(), token.size()});
+    writer.Key("playerId").Number(*response.playerId);
+    writer.EndObject();
+}
+
+void WriteJson(util::JsonWriter &writer, const GetPlayersResponse &response) {
+    writer.BeginObject();
+    for (const auto &dog : response.session.GetDogs()) {
+        writer.Key(IdKey{dog.GetId()}).BeginObject().Key("name").String(dog.GetName()).EndObject();
     }
+    writer.EndObject();
 }
 
-void tag_invoke(value_from_tag, value &value, const GetStateResponse &response) {
-    value = {};
-    auto &obj = value.as_object();
-    obj["players"] = object{};
+void WriteJson(util::JsonWriter &writer, const GetStateResponse &response) {
+    const auto &session = response.session;
+    writer.Reserve(session.GetDogs().Size() * dog_state_size);
+    writer.BeginObject().Key("players").BeginObject();
+    for (const auto &dog : session.GetDogs()) {
+        WriteDogState(writer, session, dog.GetIndex());
+    }
+    writer.EndObject().EndObject();
+}
 
-    for (const auto &[key, value] : response.players) {
-        const auto &dog = value->GetDog();
-        boost::json::value ident = *value->GetId();
-        auto [x, y] = dog->GetPosition();
-        auto [dx, dy] = dog->GetSpeed();
-        obj[ident.as_string()] = {{"pos", {x, y}}, {"speed", {dx, dy}}, {"dir", serialize(dog->GetDirection())}};
+void WriteJson(util::JsonWriter &writer, const GetStateDeltaResponse &response) {
+    const auto &session = response.session;
+    writer.BeginObject();
+    writer.Key("version").Number(session.GetVersion());
+    writer.Key("players").BeginObject();
+    const bool delta = session.GetChangeLog().ForEachChangedSince(
+        response.since, [&](DogStore::Index index) { WriteDogState(writer, session, index); });
+    if (!delta) {
+        writer.Reserve(session.GetDogs().Size() * dog_state_size);
+        for (const auto &dog : session.GetDogs()) {
+            WriteDogState(writer, session, dog.GetIndex());
+        }
     }
+    writer.EndObject();
+    writer.Key("full").Bool(!delta);
+    writer.EndObject();
 }
 
 } // namespace api::responses
@@ -2,12 +2,14 @@
 
 #include <boost/json.hpp>
 
+#include <chrono>
 #include <string>
 
 #include "basic.hpp"
 #include "game.hpp"
 #include "map.hpp"
 #include "util/error.hpp"
+#include "util/json_writer.hpp"
 #include "util/response.hpp"
 
 namespace model {
@@ -47,22 +49,33 @@ struct JoinResponse {
     Player::Id playerId;
 };
 
-// Serialize join response to json value
-void tag_invoke(value_from_tag, value &value, const JoinResponse &response);
+// Write join response to json stream
+void WriteJson(util::JsonWriter &writer, const JoinResponse &response);
 
+// Every dog of the session belongs to a player
 struct GetPlayersResponse {
-    const std::unordered_map<Player::Id, std::shared_ptr<Player>> &players;
+    const GameSession &session;
 };
 
-// Serialize get players response to json value
-void tag_invoke(value_from_tag, value &value, const GetPlayersResponse &response);
+// Write get players response to json stream
+void WriteJson(util::JsonWriter &writer, const GetPlayersResponse &response);
 
 struct GetStateResponse {
-    const std::unordered_map<Player::Id, std::shared_ptr<Player>> &players;
+    const GameSession &session;
 };
 
-// Serialize get state response to json value
-void tag_invoke(value_from_tag, value &value, const GetStateResponse &response);
+// Write get state response to json stream
+void WriteJson(util::JsonWriter &writer, const GetStateResponse &response);
+
+// Dogs changed after the version the client has seen; the full state if the version is too old
+// or a dog has left since then, so there is no list of removed ones
+struct GetStateDeltaResponse {
+    const GameSession &session;
+    GameSession::Version since;
+};
+
+// Write get state delta response to json stream
+void WriteJson(util::JsonWriter &writer, const GetStateDeltaResponse &response);
 
 } // namespace api::responses
 
@@ -131,6 +144,15 @@ static util::Response invalid_endpoint() {
         .no_cache();
 }
 
+static util::Response service_unavailable(std::chrono::seconds retry_after) {
+    auto response =
+        util::Response::Json(status::service_unavailable,
+                             value_from(util::Error{.code = "serviceUnavailable", .message = "Server is overloaded"}))
+            .no_cache();
+    response.set("Retry-After", std::to_string(retry_after.count()));
+    return response;
+}
+
 } // namespace api::errors
 
 } // namespace model
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <boost/json.hpp>
 #include <string_view>
 
+#include "util/fixed_point.hpp"
+
 namespace model {
 
 using namespace boost::json;
@@ -10,6 +12,13 @@ using namespace boost::json;
 using Dimension = int;
 using Coord = Dimension;
 
+#ifdef FIXED_POINT_COORDINATES
+// Координаты и скорости псов в 1/1024 единицы карты: симуляция побитово воспроизводима на любой машине
+using Real = util::FixedPoint<10>;
+#else
+using Real = double;
+#endif
+
 struct Point {
     Coord x, y;
 
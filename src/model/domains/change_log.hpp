@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "dog_store.hpp"
+
+namespace model {
+
+// Dogs changed in the versions of a session.
+// Every join, action or tick makes a new version. The changed dogs are kept in a list ordered by the version
+// of their last change, a change moves the dog to the end, so collecting the changes since a version costs
+// O(dogs changed since then) however many versions have passed, and returns every changed dog once.
+// Versions of a run start at a random base, so a version left from an earlier run of the server is unknown
+class ChangeLog {
+  public:
+    using Version = std::uint64_t;
+
+    ChangeLog() : version_(GetRunBase()), removed_version_(version_) {}
+
+    Version GetVersion() const noexcept { return version_; }
+
+    // Start a new version, the following changes belong to it
+    void NextVersion() noexcept { ++version_; }
+
+    void MarkChanged(DogStore::Index index) {
+        if (index >= last_changed_.size()) {
+            last_changed_.resize(index + 1, unchanged);
+            links_.resize(index + 1, {none, none});
+        }
+        if (last_changed_[index] != unchanged) {
+            Unlink(index);
+        }
+        last_changed_[index] = version_;
+        links_[index] = {last_, none};
+        if (last_ != none) {
+            links_[last_].next = index;
+        }
+        last_ = index;
+    }
+
+    // A removed dog can't be reported as changed, so the clients which saw it get the full state
+    void MarkRemoved(DogStore::Index index) {
+        if (index < last_changed_.size() && last_changed_[index] != unchanged) {
+            Unlink(index);
+            last_changed_[index] = unchanged;
+        }
+        removed_version_ = version_;
+    }
+
+    // Call fn(index) for every dog changed after the version, the latest changes go first.
+    // Returns false if the version hasn't been made by this run or a dog has been removed since then,
+    // the changes are unknown
+    template <typename Fn>
+    bool ForEachChangedSince(Version since, Fn &&fn) const {
+        if (since < removed_version_ || since > version_) {
+            return false;
+        }
+        for (auto index = last_; index != none && last_changed_[index] > since; index = links_[index].prev) {
+            fn(index);
+        }
+        return true;
+    }
+
+  private:
+    static constexpr Version unchanged = 0;
+    static constexpr DogStore::Index none = static_cast<DogStore::Index>(-1);
+
+    struct Links {
+        DogStore::Index prev;
+        DogStore::Index next;
+    };
+
+    // A nonzero 12-bit number of the run in the high bits leaves 2^40 versions to each run
+    // and keeps the versions exact as JSON numbers
+    static Version GetRunBase() {
+        static const Version base = [] {
+            std::random_device random_device;
+            std::uniform_int_distribution<Version> dist(1, (1 << 12) - 1);
+            return dist(random_device) << 40;
+        }();
+        return base;
+    }
+
+    void Unlink(DogStore::Index index) noexcept {
+        const auto [prev, next] = links_[index];
+        if (prev != none) {
+            links_[prev].next = next;
+        }
+        (next == none ? last_ : links_[next].prev) = prev;
+    }
+
+    Version version_;
+    // Version of the last removal, versions before it are unknown as well as those of earlier runs
+    Version removed_version_;
+    std::vector<Version> last_changed_;
+    std::vector<Links> links_;
+    DogStore::Index last_ = none;
+};
+
+} // namespace model
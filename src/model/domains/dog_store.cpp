@@ -0,0 +1,204 @@
+#include "dog_store.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace model {
+
+namespace {
+
+#ifdef FIXED_POINT_COORDINATES
+// Tick duration in whole milliseconds, the distance is computed with integers only
+using Duration = std::int64_t;
+
+Duration ToDuration(double milliseconds) { return std::llround(milliseconds); }
+
+Real Travel(Real speed, Duration duration) { return Real::FromRaw(speed.GetRaw() * duration / 1000); }
+#else
+// Tick duration in seconds
+using Duration = double;
+
+Duration ToDuration(double milliseconds) { return milliseconds / 1000.0; }
+
+Real Travel(Real speed, Duration duration) { return speed * duration; }
+#endif
+
+// No branches inside the loop: a dog leaving its bounds is clamped to them,
+// the distance it has not moved is stored as overshoot
+void MoveDogs(std::size_t size, Duration duration, Real *__restrict x, Real *__restrict y, const Real *__restrict vx,
+              const Real *__restrict vy, const Real *__restrict min_x, const Real *__restrict max_x,
+              const Real *__restrict min_y, const Real *__restrict max_y, Real *__restrict overshoot) noexcept {
+    using std::abs;
+    for (std::size_t i = 0; i < size; ++i) {
+        const Real new_x = x[i] + Travel(vx[i], duration);
+        const Real new_y = y[i] + Travel(vy[i], duration);
+        const Real clamped_x = std::min(std::max(new_x, min_x[i]), max_x[i]);
+        const Real clamped_y = std::min(std::max(new_y, min_y[i]), max_y[i]);
+
+        x[i] = clamped_x;
+        y[i] = clamped_y;
+        overshoot[i] = abs(new_x - clamped_x) + abs(new_y - clamped_y);
+    }
+}
+
+} // namespace
+
+DogStore::Index DogStore::Add(std::pair<Real, Real> position) {
+    constexpr Real lowest = std::numeric_limits<Real>::lowest();
+    constexpr Real max = std::numeric_limits<Real>::max();
+
+    Index index;
+    if (free_indices_.empty()) {
+        index = x_.size();
+        const std::size_t slot = index;
+        x_.resize(slot + 1);
+        y_.resize(slot + 1);
+        vx_.resize(slot + 1);
+        vy_.resize(slot + 1);
+        min_x_.resize(slot + 1);
+        max_x_.resize(slot + 1);
+        min_y_.resize(slot + 1);
+        max_y_.resize(slot + 1);
+        direction_.resize(slot + 1);
+        road_.resize(slot + 1);
+        overshoot_.resize(slot + 1);
+        slots_.push_back(slot);
+        indices_.push_back(index);
+    } else {
+        // The slot of a removed dog is out of the active set
+        index = free_indices_.back();
+        free_indices_.pop_back();
+    }
+
+    const std::size_t slot = slots_[index];
+    x_[slot] = position.first;
+    y_[slot] = position.second;
+    vx_[slot] = vy_[slot] = Real{};
+    min_x_[slot] = min_y_[slot] = lowest;
+    max_x_[slot] = max_y_[slot] = max;
+    // После добавления на карту пёс должен иметь скорость, равную нулю. Направление пса по умолчанию — на север.
+    direction_[slot] = Direction::NORTH;
+    road_[slot] = RoadIndex::no_road;
+    overshoot_[slot] = Real{};
+    return index;
+}
+
+DogStore::Index DogStore::Add(const DogState &state) {
+    const Index index = Add(std::pair{state.x, state.y});
+    SetMovement(index, {state.vx, state.vy}, state.direction, state.bounds, state.road);
+    return index;
+}
+
+DogStore::DogState DogStore::GetState(Index index) const {
+    const std::size_t slot = slots_[index];
+    return {x_[slot],
+            y_[slot],
+            vx_[slot],
+            vy_[slot],
+            {min_x_[slot], max_x_[slot], min_y_[slot], max_y_[slot]},
+            direction_[slot],
+            road_[slot]};
+}
+
+void DogStore::SetMovement(Index index, std::pair<Real, Real> speed, Direction direction, const Bounds &bounds,
+                           RoadIndex::RoadIndexType road) {
+    const std::size_t slot = slots_[index];
+    vx_[slot] = speed.first;
+    vy_[slot] = speed.second;
+    direction_[slot] = direction;
+    min_x_[slot] = bounds.min_x;
+    max_x_[slot] = bounds.max_x;
+    min_y_[slot] = bounds.min_y;
+    max_y_[slot] = bounds.max_y;
+    road_[slot] = road;
+
+    if (speed.first == Real{} && speed.second == Real{}) {
+        Deactivate(slot);
+    } else {
+        Activate(slot);
+    }
+}
+
+void DogStore::Stop(Index index) {
+    const std::size_t slot = slots_[index];
+    vx_[slot] = vy_[slot] = Real{};
+    Deactivate(slot);
+}
+
+void DogStore::Remove(Index index) {
+    Stop(index);
+    free_indices_.push_back(index);
+}
+
+void DogStore::Tick(double milliseconds, std::size_t begin, std::size_t end) noexcept {
+    MoveDogs(end - begin, ToDuration(milliseconds), x_.data() + begin, y_.data() + begin, vx_.data() + begin,
+             vy_.data() + begin, min_x_.data() + begin, max_x_.data() + begin, min_y_.data() + begin,
+             max_y_.data() + begin, overshoot_.data() + begin);
+}
+
+void DogStore::FinishTick(const Map &map) {
+    for (std::size_t slot = 0; slot < active_count_;) {
+        if (overshoot_[slot] == Real{}) {
+            ++slot;
+            continue;
+        }
+
+        const bool horizontal = vx_[slot] != Real{};
+        const bool forward = horizontal ? vx_[slot] > Real{} : vy_[slot] > Real{};
+        bool stopped = true;
+        if (road_[slot] != RoadIndex::no_road) {
+            auto [road, coord, road_ended] = map.Advance(road_[slot], horizontal ? x_[slot] : y_[slot], forward,
+                                                         overshoot_[slot]);
+            auto [min, max] = map.GetRoadSpan(road);
+            (horizontal ? x_ : y_)[slot] = coord;
+            (horizontal ? min_x_ : min_y_)[slot] = min;
+            (horizontal ? max_x_ : max_y_)[slot] = max;
+            road_[slot] = road;
+            stopped = road_ended;
+        }
+        overshoot_[slot] = Real{};
+
+        if (stopped) {
+            // The last active dog takes this slot, so it is checked again
+            vx_[slot] = vy_[slot] = Real{};
+            Deactivate(slot);
+        } else {
+            ++slot;
+        }
+    }
+}
+
+void DogStore::Activate(std::size_t slot) noexcept {
+    if (slot >= active_count_) {
+        SwapSlots(slot, active_count_++);
+    }
+}
+
+void DogStore::Deactivate(std::size_t slot) noexcept {
+    if (slot < active_count_) {
+        SwapSlots(slot, --active_count_);
+    }
+}
+
+void DogStore::SwapSlots(std::size_t lhs, std::size_t rhs) noexcept {
+    if (lhs == rhs) {
+        return;
+    }
+    std::swap(x_[lhs], x_[rhs]);
+    std::swap(y_[lhs], y_[rhs]);
+    std::swap(vx_[lhs], vx_[rhs]);
+    std::swap(vy_[lhs], vy_[rhs]);
+    std::swap(min_x_[lhs], min_x_[rhs]);
+    std::swap(max_x_[lhs], max_x_[rhs]);
+    std::swap(min_y_[lhs], min_y_[rhs]);
+    std::swap(max_y_[lhs], max_y_[rhs]);
+    std::swap(direction_[lhs], direction_[rhs]);
+    std::swap(road_[lhs], road_[rhs]);
+    std::swap(overshoot_[lhs], overshoot_[rhs]);
+    std::swap(indices_[lhs], indices_[rhs]);
+    slots_[indices_[lhs]] = lhs;
+    slots_[indices_[rhs]] = rhs;
+}
+
+} // namespace model
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "basic.hpp"
+#include "map.hpp"
+
+namespace model {
+
+// Dynamic state of the dogs of one game session stored as a structure of arrays.
+// Moving dogs are kept in a prefix of the arrays (the active set), so the tick walks plain
+// contiguous arrays of moving dogs only and the compiler is able to vectorize it.
+// Dogs are addressed by stable indices which are mapped to their current slots.
+// The vectorized pass moves dogs within the road they are on; the few dogs which reach
+// the end of their road are carried onto the next roads by FinishTick.
+class DogStore {
+  public:
+    using Index = std::size_t;
+
+    // Area the dog is allowed to move within until it reaches the end of the road
+    struct Bounds {
+        Real min_x, max_x;
+        Real min_y, max_y;
+    };
+
+    // Complete state of a dog, used to save and restore sessions
+    struct DogState {
+        Real x, y;
+        Real vx, vy;
+        Bounds bounds;
+        Direction direction;
+        RoadIndex::RoadIndexType road;
+    };
+
+    // The index of a removed dog is reused by the next one
+    Index Add(std::pair<Real, Real> position);
+
+    Index Add(const DogState &state);
+
+    DogState GetState(Index index) const;
+
+    // The dog stays in its slot out of the active set until the index is reused
+    void Remove(Index index);
+
+    // Number of dogs, removed ones included
+    std::size_t Size() const noexcept { return x_.size(); }
+
+    // Number of moving dogs
+    std::size_t GetActiveCount() const noexcept { return active_count_; }
+
+    std::span<const Index> GetActiveIndices() const noexcept { return {indices_.data(), active_count_}; }
+
+    std::pair<Real, Real> GetPosition(Index index) const { return {x_[slots_[index]], y_[slots_[index]]}; }
+
+    std::pair<Real, Real> GetSpeed(Index index) const { return {vx_[slots_[index]], vy_[slots_[index]]}; }
+
+    Direction GetDirection(Index index) const { return direction_[slots_[index]]; }
+
+    // Road is the one the dog moves along or RoadIndex::no_road if it moves across a road
+    void SetMovement(Index index, std::pair<Real, Real> speed, Direction direction, const Bounds &bounds,
+                     RoadIndex::RoadIndexType road);
+
+    void Stop(Index index);
+
+    // Move every moving dog by its speed; dogs reaching the end of the last road are stopped there
+    void Tick(double milliseconds, const Map &map) {
+        Tick(milliseconds, 0, active_count_);
+        FinishTick(map);
+    }
+
+    // Move active dogs in slots [begin, end) within their roads only, disjoint ranges may be ticked
+    // concurrently. FinishTick must be called once all the ranges have been ticked
+    void Tick(double milliseconds, std::size_t begin, std::size_t end) noexcept;
+
+    // Move dogs which reached the end of their road during the last tick onto the next roads,
+    // stop and deactivate those with no road ahead
+    void FinishTick(const Map &map);
+
+  private:
+    void Activate(std::size_t slot) noexcept;
+    void Deactivate(std::size_t slot) noexcept;
+    void SwapSlots(std::size_t lhs, std::size_t rhs) noexcept;
+
+    std::vector<Real> x_, y_;
+    std::vector<Real> vx_, vy_;
+    std::vector<Real> min_x_, max_x_, min_y_, max_y_;
+    std::vector<Direction> direction_;
+    std::vector<RoadIndex::RoadIndexType> road_;
+    // Distance left to move after the dog has been clamped to its bounds by the last tick
+    std::vector<Real> overshoot_;
+
+    // Slot of every dog index and index of the dog in every slot
+    std::vector<std::size_t> slots_;
+    std::vector<Index> indices_;
+    std::size_t active_count_ = 0;
+    std::vector<Index> free_indices_;
+};
+
+} // namespace model
@@ -1,5 +1,9 @@
 #include "game.hpp"
 
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
 using namespace std::literals;
 
 namespace model {
@@ -12,25 +16,290 @@ Game tag_invoke(value_to_tag<Game>, const value &value) {
     if (obj.contains("defaultDogSpeed")) {
         default_dog_speed = obj.at("defaultDogSpeed").as_double();
     }
+    std::optional<std::size_t> default_max_players;
+    if (obj.contains("defaultMaxPlayers")) {
+        default_max_players = value_to<std::size_t>(obj.at("defaultMaxPlayers"));
+        if (*default_max_players < 1) {
+            throw std::invalid_argument("defaultMaxPlayers must be at least 1");
+        }
+    }
     for (auto &map : maps) {
         if (!map.GetDogSpeed())
             map.SetDogSpeed(default_dog_speed);
+        if (!map.GetMaxPlayers() && default_max_players)
+            map.SetMaxPlayers(*default_max_players);
     }
 
     return Game{std::move(maps)};
 }
 
-void tag_invoke(value_from_tag, value &value, const Game::Maps &maps) {
-    array maps_array;
-
+void WriteJson(util::JsonWriter &writer, const Game::Maps &maps) {
+    writer.BeginArray();
     for (const auto &map : maps) {
-        object res_object;
-        res_object["id"sv] = *map.GetId();
-        res_object["name"sv] = map.GetName();
-        maps_array.push_back(res_object);
+        writer.BeginObject().Key("id"sv).String(*map.GetId()).Key("name"sv).String(map.GetName()).EndObject();
+    }
+    writer.EndArray();
+}
+
+GameSession::DogHandle GameSession::RestoreDog(Dog::Id id, std::string name, const DogStore::DogState &state) {
+    if (state.road != RoadIndex::no_road && state.road >= map_.GetRoads().size()) {
+        throw std::invalid_argument("Dog "s + std::to_string(*id) + " is on road "s + std::to_string(state.road) +
+                                    " which the map "s + *map_.GetId() + " doesn't have"s);
+    }
+    // Псы всегда смотрят в одну из сторон света, Direction::NO только останавливает их
+    const auto direction = static_cast<std::underlying_type_t<Direction>>(state.direction);
+    if (direction < static_cast<std::underlying_type_t<Direction>>(Direction::NORTH) ||
+        direction > static_cast<std::underlying_type_t<Direction>>(Direction::EAST)) {
+        throw std::invalid_argument("Dog "s + std::to_string(*id) + " has an invalid direction"s);
+    }
+    return InsertDog(Dog::Restore(id, std::move(name), dog_store_.Add(state)));
+}
+
+void GameSession::MoveDog(const Dog &dog, Direction direction) {
+    constexpr Real lowest = std::numeric_limits<Real>::lowest();
+    constexpr Real max_coord = std::numeric_limits<Real>::max();
+
+    const auto index = dog.GetIndex();
+    change_log_.NextVersion();
+    change_log_.MarkChanged(index);
+    if (direction == Direction::NO) {
+        dog_store_.Stop(index);
+        return;
     }
 
-    value = maps_array;
+    auto [x, y] = dog_store_.GetPosition(index);
+    const Point point{static_cast<int>(std::round(static_cast<double>(x))),
+                      static_cast<int>(std::round(static_cast<double>(y)))};
+    const Real speed = map_.GetDogSpeed().value();
+
+    const bool horizontal = direction == Direction::WEST || direction == Direction::EAST;
+    const bool forward = direction == Direction::SOUTH || direction == Direction::EAST;
+    const auto orientation = horizontal ? Orientation::HORIZONTAL : Orientation::VERTICAL;
+
+    auto road = map_.FindRoad(point, orientation, forward);
+    // Without a road of the orientation here the dog can move only across the road it stays on
+    const Coord coord = horizontal ? point.x : point.y;
+    auto [min, max] = road ? map_.GetRoadSpan(*road)
+                           : std::pair<Real, Real>{coord - Map::road_half_width, coord + Map::road_half_width};
+
+    const Real signed_speed = forward ? speed : -speed;
+    if (horizontal) {
+        dog_store_.SetMovement(index, {signed_speed, Real{}}, direction, {min, max, lowest, max_coord},
+                               road.value_or(RoadIndex::no_road));
+    } else {
+        dog_store_.SetMovement(index, {Real{}, signed_speed}, direction, {lowest, max_coord, min, max},
+                               road.value_or(RoadIndex::no_road));
+    }
+}
+
+std::uint64_t Game::GetSessionSeed(const Map::Id &id, std::size_t instance) const {
+    if (!random_seed_) {
+        std::random_device random_device;
+        std::uniform_int_distribution<std::uint64_t> dist;
+        return dist(random_device);
+    }
+
+    // FNV-1a of the map id mixed into the game seed, so the stream doesn't depend on the standard library
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : *id) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    // The first instance keeps the stream it had before maps got several sessions
+    return *random_seed_ ^ hash ^ (instance * 0x9e3779b97f4a7c15ull);
+}
+
+Player *Game::GetPlayer(std::string_view token) {
+    if (!token_signer_) {
+        auto handle = player_tokens_.FindPlayerByToken(token);
+        return handle ? players_.Get(*handle) : nullptr;
+    }
+
+    // A signed token names the player itself, a forged one is rejected without touching any table
+    auto value = Token::FromHex(token);
+    if (!value) {
+        return nullptr;
+    }
+    auto payload = token_signer_->Verify(*value);
+    return payload ? GetPlayer(*payload) : nullptr;
+}
+
+Player *Game::GetPlayer(const TokenSigner::Payload &payload) {
+    if (payload.map_index >= maps_.size()) {
+        return nullptr;
+    }
+    auto *player = players_.Find(Dog::Id{payload.dog_id});
+    if (!player || player->GetSession().GetMap().GetId() != maps_[payload.map_index].GetId()) {
+        return nullptr;
+    }
+    return player;
+}
+
+Player &Game::GetPlayer(const Map::Id &map_id, Dog::Id dog_id) {
+    auto *player = players_.Find(dog_id);
+    if (!player || player->GetSession().GetMap().GetId() != map_id) {
+        throw std::out_of_range("Player "s + std::to_string(*dog_id) + " has not been found"s);
+    }
+    return *player;
+}
+
+GameSession &Game::PlaceSession(MapHandle map) {
+    auto &instances = sessions_[map];
+    auto &placement = placements_[map];
+    const auto max_players = maps_[map].GetMaxPlayers();
+
+    while (!placement.open.empty()) {
+        const auto [players, instance, stamp] = placement.open.top();
+        if (instance >= instances.size() || !instances[instance] || placement.stamps[instance] != stamp) {
+            placement.open.pop();
+            continue;
+        }
+        auto &session = *instances[instance];
+        const auto load = session.GetDogs().Size();
+        if (load == players) {
+            return session;
+        }
+        placement.open.pop();
+        if (!max_players || load < *max_players) {
+            placement.open.push({load, instance, stamp});
+        }
+    }
+
+    while (placement.first_free < instances.size() && instances[placement.first_free]) {
+        ++placement.first_free;
+    }
+    return OpenSession(map, placement.first_free);
+}
+
+GameSession &Game::OpenSession(MapHandle map, std::size_t instance) {
+    auto &instances = sessions_[map];
+    if (instance >= instances.size()) {
+        instances.resize(instance + 1);
+    }
+    if (!instances[instance]) {
+        instances[instance] =
+            std::make_unique<GameSession>(maps_[map], map, instance, GetSessionSeed(maps_[map].GetId(), instance));
+        OfferSession(map, instance);
+    }
+    return *instances[instance];
+}
+
+void Game::OfferSession(MapHandle map, std::size_t instance) {
+    auto &instances = sessions_[map];
+    auto &placement = placements_[map];
+    if (instance >= placement.stamps.size()) {
+        placement.stamps.resize(instances.size());
+    }
+    placement.stamps[instance] = ++placement.next_stamp;
+
+    // Outdated entries are dropped only at the top, a heap of them is rebuilt from the open sessions
+    if (placement.open.size() > 2 * instances.size() + 16) {
+        std::vector<Placement::Entry> entries;
+        for (std::size_t i = 0; i < instances.size(); ++i) {
+            if (instances[i] && i != instance) {
+                entries.push_back({instances[i]->GetDogs().Size(), i, placement.stamps[i]});
+            }
+        }
+        placement.open = decltype(placement.open)(std::greater<>{}, std::move(entries));
+    }
+    placement.open.push({instances[instance]->GetDogs().Size(), instance, placement.stamps[instance]});
+}
+
+bool Game::RemoveSession(MapHandle map, std::size_t instance) {
+    auto &instances = sessions_[map];
+    if (instance >= instances.size() || !instances[instance] || instances[instance]->GetDogs().Size() != 0) {
+        return false;
+    }
+    auto &placement = placements_[map];
+    instances[instance].reset();
+    placement.stamps[instance] = ++placement.next_stamp;
+    placement.first_free = std::min(placement.first_free, instance);
+    while (!instances.empty() && !instances.back()) {
+        instances.pop_back();
+    }
+    return true;
+}
+
+bool Game::RemovePlayer(Token token) {
+    auto handle = player_tokens_.FindPlayer(token);
+    if (!handle) {
+        return false;
+    }
+    auto &player = *players_.Get(*handle);
+    auto &session = player.GetSession();
+    if (listener_) {
+        listener_->OnLeave(player, token);
+    }
+    const auto dog = player.GetDogHandle();
+    players_.Remove(*handle);
+    session.RemoveDog(dog);
+    player_tokens_.RemovePlayer(token);
+
+    const auto map = session.GetMapHandle();
+    const auto instance = session.GetInstance();
+    if (session.GetDogs().Size() == 0) {
+        RemoveSession(map, instance);
+    } else {
+        OfferSession(map, instance);
+    }
+    return true;
+}
+
+GameSession &Game::RestoreSession(const Map::Id &map_id, std::size_t instance) {
+    auto map = FindMap(map_id);
+    if (!map) {
+        throw std::invalid_argument("Map with id "s + *map_id + " doesn't exist"s);
+    }
+    return OpenSession(*map, instance);
+}
+
+void Game::RestorePlayer(const Map::Id &map_id, std::size_t instance, Dog::Id dog_id, std::string name, Token token,
+                         const DogStore::DogState &state) {
+    auto &session = RestoreSession(map_id, instance);
+    auto player = players_.Add(session, session.RestoreDog(dog_id, std::move(name), state));
+    if (!player_tokens_.AddPlayer(player, token)) {
+        throw std::invalid_argument("Token of player "s + std::to_string(*dog_id) + " is already taken"s);
+    }
+}
+
+void Game::Tick(double milliseconds) {
+    // Large sessions are split into chunks so that a single map can be ticked by several threads
+    constexpr std::size_t chunk_size = 4096;
+
+    // Sessions without moving dogs are not touched at all
+    std::vector<GameSession *> active_sessions;
+    for (auto &instances : sessions_) {
+        for (auto &session : instances) {
+            if (session && session->GetDogStore().GetActiveCount() != 0) {
+                active_sessions.push_back(session.get());
+            }
+        }
+    }
+
+    if (listener_) {
+        listener_->OnTick(milliseconds, active_sessions.empty());
+    }
+
+    if (!tick_pool_) {
+        for (auto *session : active_sessions) {
+            session->Tick(milliseconds);
+        }
+        return;
+    }
+
+    std::vector<util::WorkerPool::Task> tasks;
+    for (auto *session : active_sessions) {
+        session->BeginTick();
+        const auto size = session->GetDogStore().GetActiveCount();
+        for (std::size_t begin = 0; begin < size; begin += chunk_size) {
+            const auto end = std::min(begin + chunk_size, size);
+            tasks.emplace_back([session, milliseconds, begin, end] { session->Tick(milliseconds, begin, end); });
+        }
+    }
+    tick_pool_->RunAll(std::move(tasks));
+
+    for (auto *session : active_sessions) {
+        session->FinishTick();
+    }
 }
 
 void Game::AddMap(Map &&map) {
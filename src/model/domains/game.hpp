@@ -3,89 +3,60 @@
 #include <algorithm>
 #include <boost/json.hpp>
 
+#include <functional>
 #include <memory>
+#include <queue>
 #include <random>
-#include <sstream>
 #include <string>
 
 #include "basic.hpp"
+#include "change_log.hpp"
+#include "dog_store.hpp"
 #include "map.hpp"
-#include "util/string_hash.hpp"
+#include "token.hpp"
+#include "util/slot_map.hpp"
+#include "util/versioned_cache.hpp"
+#include "util/worker_pool.hpp"
 
 namespace model {
 
 using namespace boost::json;
 
 // Пес — персонаж, которым управляет игрок.
+// Координаты, скорость и направление пса хранятся в DogStore игровой сессии.
 class Dog {
   public:
     using Id = util::Tagged<std::size_t, Dog>;
 
-    static std::shared_ptr<Dog> Create(std::string name, const Map &map, bool randomize_spawn_points) {
-        // Координаты пса — случайно выбранная точка на случайно выбранном отрезке дороги этой карты
-        static std::size_t last_id = 0;
-
-        std::pair<double, double> position;
-        if (randomize_spawn_points) {
-            const auto &roads = map.GetRoads();
-            std::mt19937_64 generator{[] {
-                std::random_device random_device;
-                std::uniform_int_distribution<std::mt19937_64::result_type> dist;
-                return dist(random_device);
-            }()};
-
-            position = [&]() -> std::pair<double, double> {
-                std::uniform_int_distribution<int> uniform_dist(0, roads.size() - 1);
-                const auto &road = roads[uniform_dist(generator)];
-                auto start = road.GetStart(), end = road.GetEnd();
-                if (road.IsVertical()) {
-                    std::uniform_int_distribution<int> uniform_dist(start.y, end.y);
-                    return {start.x, uniform_dist(generator)};
-                } else if (road.IsHorizontal()) {
-                    std::uniform_int_distribution<int> uniform_dist(start.x, end.x);
-                    return {uniform_dist(generator), start.y};
-                }
-            }();
-        } else {
-            auto [x, y] = map.GetRoads()[0].GetStart();
-            position = {x, y};
-        }
+    static Dog Create(std::string name, DogStore::Index index) { return Dog(Id{next_id_++}, std::move(name), index); }
 
-        return std::shared_ptr<Dog>(new Dog(Id{last_id++}, name, position));
+    // Recreate a saved dog; dogs created later get greater ids
+    static Dog Restore(Id id, std::string name, DogStore::Index index) {
+        next_id_ = std::max(next_id_, *id + 1);
+        return Dog(id, std::move(name), index);
+    }
+
+    // Координаты пса — случайно выбранная точка дорог этой карты, все точки равновероятны
+    static std::pair<double, double> GetSpawnPosition(const Map &map, bool randomize_spawn_points,
+                                                      std::mt19937_64 &generator) {
+        auto [x, y] = randomize_spawn_points ? map.GetSpawnSampler().Sample(generator) : map.GetRoads()[0].GetStart();
+        return {x, y};
     }
 
     Id GetId() const { return id_; }
 
     std::string_view GetName() const { return name_; }
 
-    std::pair<double, double> GetPosition() const { return position_; }
-
-    std::pair<double, double> GetSpeed() const { return speed_; }
-
-    Direction GetDirection() const { return direction_; }
-
-    void SetPosition(std::pair<double, double> position) { position_ = position; }
-
-    void SetSpeed(std::pair<double, double> speed) { speed_ = speed; }
-
-    void SetDirection(Direction direction) { direction_ = direction; }
+    DogStore::Index GetIndex() const { return index_; }
 
   private:
-    // После добавления на карту пёс должен иметь скорость, равную нулю. Направление пса по умолчанию — на север.
-    Dog(Id id, std::string name, std::pair<double, double> position)
-        : id_(id), name_(std::move(name)), position_(position), speed_({0.0, 0.0}), direction_(Direction::NORTH) {}
+    Dog(Id id, std::string name, DogStore::Index index) : id_(id), name_(std::move(name)), index_(index) {}
+
+    inline static std::size_t next_id_ = 0;
 
     Id id_;
     std::string name_;
-    // Координаты пса на карте задаются двумя вещественными числами. Для описания вещественных координат разработайте
-    // структуру или класс.
-    std::pair<double, double> position_;
-    // Скорость пса на карте задаётся также двумя вещественными числами. Скорость измеряется в единицах карты за одну
-    // секунду
-    std::pair<double, double> speed_;
-    // Направление в пространстве принимает одно из четырех значений: NORTH (север), SOUTH (юг), WEST (запад), EAST
-    // (восток).
-    Direction direction_;
+    DogStore::Index index_;
 };
 
 // Deserialize json value to dog structure
@@ -93,21 +64,113 @@ Dog tag_invoke(value_to_tag<Dog>, const value &value);
 // Serialize dog to json value
 void tag_invoke(value_from_tag, value &value, const Dog &dog);
 
+// Index of the map in the game: the id is looked up once, then sessions are found by plain indexing
+using MapHandle = std::size_t;
+
 class GameSession {
   public:
-    using Dogs = std::unordered_map<Dog::Id, std::shared_ptr<Dog>>;
-
-    GameSession(const Map &map) : map_(map) {}
+    using Dogs = util::SlotMap<Dog>;
+    using DogHandle = Dogs::Handle;
+    using Version = ChangeLog::Version;
+
+    // Every random choice of the session is made by a generator seeded with seed.
+    // Instance tells apart the sessions of one map
+    GameSession(const Map &map, MapHandle map_handle, std::size_t instance, std::uint64_t seed)
+        : map_(map), map_handle_(map_handle), instance_(instance), generator_(seed) {}
+
+    DogHandle AddDog(std::string name, bool randomize_spawn_points) {
+        auto index = dog_store_.Add(Dog::GetSpawnPosition(map_, randomize_spawn_points, generator_));
+        return InsertDog(Dog::Create(std::move(name), index));
+    }
 
-    void AddDog(std::shared_ptr<Dog> dog) { dogs_.insert({dog->GetId(), std::move(dog)}); }
+    // The state comes from a file which may have been saved for another config of the map:
+    // throws std::invalid_argument if the road or the direction is out of range
+    DogHandle RestoreDog(Dog::Id id, std::string name, const DogStore::DogState &state);
+
+    // The dog leaves the session, its handle becomes stale
+    void RemoveDog(DogHandle handle) {
+        const auto index = dogs_.Get(handle)->GetIndex();
+        dogs_.Erase(handle);
+        dog_store_.Remove(index);
+        ++players_version_;
+        change_log_.NextVersion();
+        change_log_.MarkRemoved(index);
+    }
 
+    // Dogs are stored contiguously, iteration doesn't chase pointers
     const Dogs &GetDogs() const { return dogs_; }
 
+    // nullptr if the handle is stale
+    const Dog *GetDog(DogHandle handle) const noexcept { return dogs_.Get(handle); }
+
+    Dog::Id GetDogId(DogStore::Index index) const { return dog_ids_[index]; }
+
+    Version GetVersion() const noexcept { return change_log_.GetVersion(); }
+
+    // Changes only when a player joins or leaves
+    Version GetPlayersVersion() const noexcept { return players_version_; }
+
+    using BodyCache = util::VersionedCache<std::shared_ptr<const std::string>>;
+
+    // Serialized state and players list shared by all the requests until the version changes
+    BodyCache &GetStateCache() noexcept { return state_cache_; }
+
+    BodyCache &GetPlayersCache() noexcept { return players_cache_; }
+
+    const ChangeLog &GetChangeLog() const noexcept { return change_log_; }
+
+    const DogStore &GetDogStore() const { return dog_store_; }
+
     const Map &GetMap() const { return map_; }
 
+    MapHandle GetMapHandle() const noexcept { return map_handle_; }
+
+    std::size_t GetInstance() const noexcept { return instance_; }
+
+    // Set the dog speed according to the direction; Direction::NO stops the dog
+    void MoveDog(const Dog &dog, Direction direction);
+
+    void Tick(double milliseconds) {
+        BeginTick();
+        dog_store_.Tick(milliseconds, map_);
+    }
+
+    // A tick split into ranges: BeginTick, then Tick of the moving dogs [begin, end) of the active set
+    // for every range, then FinishTick
+    void BeginTick() {
+        change_log_.NextVersion();
+        for (auto index : dog_store_.GetActiveIndices()) {
+            change_log_.MarkChanged(index);
+        }
+    }
+
+    void Tick(double milliseconds, std::size_t begin, std::size_t end) { dog_store_.Tick(milliseconds, begin, end); }
+
+    void FinishTick() { dog_store_.FinishTick(map_); }
+
   private:
+    DogHandle InsertDog(Dog &&dog) {
+        if (dog.GetIndex() >= dog_ids_.size()) {
+            dog_ids_.resize(dog.GetIndex() + 1, dog.GetId());
+        }
+        dog_ids_[dog.GetIndex()] = dog.GetId();
+        ++players_version_;
+        change_log_.NextVersion();
+        change_log_.MarkChanged(dog.GetIndex());
+        return dogs_.Emplace(std::move(dog));
+    }
+
     Dogs dogs_;
+    std::vector<Dog::Id> dog_ids_;
+    ChangeLog change_log_;
+    Version players_version_ = 0;
+    BodyCache state_cache_;
+    BodyCache players_cache_;
+    DogStore dog_store_;
     const Map &map_;
+    MapHandle map_handle_;
+    std::size_t instance_;
+    std::mt19937_64 generator_;
 };
 
 // Deserialize json value to game session structure
@@ -115,34 +178,28 @@ GameSession tag_invoke(value_to_tag<GameSession>, const value &value);
 // Serialize game session to json value
 void tag_invoke(value_from_tag, value &value, const GameSession &session);
 
-namespace detail {
-
-struct TokenTag {};
-
-} // namespace detail
-
-using Token = util::Tagged<std::string_view, detail::TokenTag>;
-
 class Player {
   public:
     using Id = Dog::Id;
 
-    Player(std::string name, GameSession &session, bool randomize_spawn_points) : session_(session) {
-        dog_ = Dog::Create(name, session.GetMap(), randomize_spawn_points);
-        session.AddDog(dog_);
-    }
+    Player(GameSession &session, GameSession::DogHandle dog) : session_(&session), dog_(dog) {}
+
+    Id GetId() const { return GetDog().GetId(); }
 
-    Id GetId() const { return dog_->GetId(); }
+    std::string_view GetName() const { return GetDog().GetName(); }
 
-    std::string_view GetName() const { return dog_->GetName(); }
+    const GameSession &GetSession() const { return *session_; }
 
-    const GameSession &GetSession() const { return session_; }
+    GameSession &GetSession() { return *session_; }
 
-    std::shared_ptr<Dog> GetDog() const { return dog_; }
+    // The dog lives as long as the player does
+    const Dog &GetDog() const { return *session_->GetDog(dog_); }
+
+    GameSession::DogHandle GetDogHandle() const noexcept { return dog_; }
 
   private:
-    GameSession &session_;
-    std::shared_ptr<Dog> dog_;
+    GameSession *session_;
+    GameSession::DogHandle dog_;
 };
 
 // Deserialize json value to player structure
@@ -150,24 +207,83 @@ Player tag_invoke(value_to_tag<Player>, const value &value);
 // Serialize player to json value
 void tag_invoke(value_from_tag, value &value, const Player &player);
 
+// Players of all the sessions in a slot map. Dog ids are dense,
+// so a player is also found by the id of its dog with a single array access
+class Players {
+  public:
+    using Handle = util::SlotMap<Player>::Handle;
+
+    Handle Add(GameSession &session, GameSession::DogHandle dog) {
+        auto handle = players_.Emplace(session, dog);
+        const auto dog_id = *players_.Get(handle)->GetId();
+        if (dog_id >= by_dog_id_.size()) {
+            by_dog_id_.resize(dog_id + 1);
+        }
+        by_dog_id_[dog_id] = handle;
+        return handle;
+    }
+
+    void Remove(Handle handle) {
+        by_dog_id_[*players_.Get(handle)->GetId()] = Handle{};
+        players_.Erase(handle);
+    }
+
+    // nullptr if the player has left; the pointer is valid until the next player is added or removed
+    Player *Get(Handle handle) noexcept { return players_.Get(handle); }
+
+    const Player *Get(Handle handle) const noexcept { return players_.Get(handle); }
+
+    // nullptr if there is no such player
+    const Player *Find(Dog::Id dog_id) const noexcept {
+        return *dog_id < by_dog_id_.size() ? players_.Get(by_dog_id_[*dog_id]) : nullptr;
+    }
+
+    Player *Find(Dog::Id dog_id) noexcept { return const_cast<Player *>(std::as_const(*this).Find(dog_id)); }
+
+    std::size_t Size() const noexcept { return players_.Size(); }
+
+  private:
+    util::SlotMap<Player> players_;
+    // Default handles of the ids without a player never match a slot
+    std::vector<Handle> by_dog_id_;
+};
+
 class PlayerTokens {
   public:
-    std::shared_ptr<Player> FindPlayerByToken(std::string_view token) {
-        auto it = token_to_player_.find(token);
-        if (it == token_to_player_.end()) {
-            return nullptr;
+    using Handle = Players::Handle;
+
+    // Token is the hex form sent by the client
+    std::optional<Handle> FindPlayerByToken(std::string_view token) const {
+        auto value = Token::FromHex(token);
+        if (!value) {
+            return std::nullopt;
         }
-        return it->second;
+        const auto *player = token_to_player_.Find(*value);
+        return player ? std::optional{*player} : std::nullopt;
     }
 
-    Token AddPlayer(std::shared_ptr<Player> player) {
-        std::stringstream stream;
-        stream << std::hex << generator1_() << generator2_();
+    Token AddPlayer(Handle player) {
+        Token token;
+        do {
+            token = Token{generator1_(), generator2_()};
+        } while (token == Token{} || !token_to_player_.Insert(token, player));
+        return token;
+    }
 
-        std::string token(stream.str());
-        auto [it, _] = token_to_player_.insert({token, player});
+    // Returns false if the token is already taken
+    bool AddPlayer(Handle player, Token token) { return token_to_player_.Insert(token, player); }
 
-        return Token{it->first};
+    std::optional<Handle> FindPlayer(Token token) const {
+        const auto *player = token_to_player_.Find(token);
+        return player ? std::optional{*player} : std::nullopt;
+    }
+
+    void RemovePlayer(Token token) { token_to_player_.Erase(token); }
+
+    // Call fn(token, player) for every player
+    template <typename Fn>
+    void ForEachPlayer(Fn &&fn) const {
+        token_to_player_.ForEach(std::forward<Fn>(fn));
     }
 
   private:
@@ -181,77 +297,119 @@ class PlayerTokens {
         return dist(random_device_);
     }()};
 
-    std::unordered_map<std::string, std::shared_ptr<Player>, string_hash, std::equal_to<>> token_to_player_;
+    TokenTable<Handle> token_to_player_;
 };
 
-class Players {
+// Receives the changes made to the game through its API, e.g. to journal them
+class GameListener {
   public:
-    using PlayersContainer = std::unordered_map<Map::Id, std::unordered_map<Dog::Id, std::shared_ptr<Player>>>;
-
-    std::shared_ptr<Player> Add(std::string name, GameSession &session, bool randomize_spawn_points) {
-        auto player = std::make_shared<Player>(name, session, randomize_spawn_points);
-        const auto &dog = player->GetDog();
-
-        players_[session.GetMap().GetId()][dog->GetId()] = player;
-        return player;
-    }
-
-    std::shared_ptr<Player> FindByDogIdAndMapId(Dog::Id dog_id, Map::Id map_id) const {
-        return players_.at(map_id).at(dog_id);
-    }
-
-    const std::unordered_map<Dog::Id, std::shared_ptr<Player>> &GetPlayers(const Map::Id &map_id) {
-        return players_[map_id];
-    }
-
-    PlayersContainer::iterator begin() { return players_.begin(); }
-
-    PlayersContainer::iterator end() { return players_.end(); }
-
-  private:
-    PlayersContainer players_;
+    virtual ~GameListener() = default;
+
+    // Called after the dog of the player has been placed at its spawn position
+    virtual void OnJoin(const Player &player, Token token) = 0;
+    virtual void OnAction(const Player &player, Direction direction) = 0;
+    // Called before the player and its dog are removed
+    virtual void OnLeave(const Player &player, Token token) = 0;
+    // Called before the sessions are ticked. The tick is idle if no dog moves, it changes nothing then
+    virtual void OnTick(double milliseconds, bool idle) = 0;
 };
 
 class Game {
   public:
     using Maps = std::vector<Map>;
+    using MapHandle = model::MapHandle;
 
     explicit Game(Maps &&maps) {
         for (auto &&map : maps) {
             AddMap(std::move(map));
         }
+        sessions_.resize(maps_.size());
+        placements_.resize(maps_.size());
     }
 
     const Maps &GetMaps() const noexcept { return maps_; }
 
-    bool ContainsMap(const Map::Id &id) noexcept { return map_id_to_index_.contains(id); }
-
-    Map &GetMap(const Map::Id &id) noexcept { return maps_[map_id_to_index_.at(id)]; }
-
-    void AddSession(GameSession &&session) { sessions_.push_back(std::move(session)); }
-
-    bool ContainsSession(const Map::Id &id) noexcept {
-        return std::find_if(sessions_.begin(), sessions_.end(),
-                            [&](const auto &session) { return id == session.GetMap().GetId(); }) != sessions_.end();
+    std::optional<MapHandle> FindMap(const Map::Id &id) const noexcept {
+        auto it = map_id_to_index_.find(id);
+        return it != map_id_to_index_.end() ? std::optional{it->second} : std::nullopt;
     }
 
-    GameSession &GetSession(const Map::Id &id) noexcept {
-        return *std::find_if(sessions_.begin(), sessions_.end(),
-                             [&](const auto &session) { return id == session.GetMap().GetId(); });
+    // Session of the map a new player joins: the least loaded one below the player limit of the map,
+    // a new instance when all of them are full. Takes O(log sessions) amortized
+    GameSession &PlaceSession(MapHandle map);
+
+    // Create the session if it doesn't exist yet.
+    // Sessions are allocated one by one, so the address stays valid until the session is removed
+    GameSession &OpenSession(MapHandle map, std::size_t instance);
+
+    // Only a session without dogs is removed, nothing refers to it then.
+    // Numbers of the other instances don't change, the free one is reused by the next new instance
+    bool RemoveSession(MapHandle map, std::size_t instance);
+
+    // Call fn(session) for every session of the game
+    template <typename Fn>
+    void ForEachSession(Fn &&fn) const {
+        for (const auto &instances : sessions_) {
+            for (const auto &session : instances) {
+                if (session) {
+                    fn(std::as_const(*session));
+                }
+            }
+        }
     }
 
-    std::pair<std::shared_ptr<Player>, Token> AddPlayer(std::string username, GameSession &session) {
-        auto player = players_.Add(std::move(username), session, randomize_spawn_points_);
-        auto token = player_tokens_.AddPlayer(player);
+    // The player is valid until the next player joins or leaves
+    std::pair<Player *, Token> AddPlayer(std::string username, GameSession &session) {
+        auto handle = players_.Add(session, session.AddDog(std::move(username), randomize_spawn_points_));
+        auto *player = players_.Get(handle);
+        Token token;
+        if (token_signer_) {
+            // The table of tokens is still filled for saving the game
+            token = token_signer_->Sign(map_id_to_index_.at(session.GetMap().GetId()), *player->GetId());
+            player_tokens_.AddPlayer(handle, token);
+        } else {
+            token = player_tokens_.AddPlayer(handle);
+        }
+        if (listener_) {
+            listener_->OnJoin(*player, token);
+        }
         return {player, token};
     }
 
-    std::shared_ptr<Player> GetPlayer(std::string_view token) { return player_tokens_.FindPlayerByToken(token); }
+    // nullptr if there is no such player
+    Player *GetPlayer(std::string_view token);
+
+    // Player of a signed token which has already been verified, nullptr if it has left
+    Player *GetPlayer(const TokenSigner::Payload &payload);
+
+    // Throws std::out_of_range if there is no such player
+    Player &GetPlayer(const Map::Id &map_id, Dog::Id dog_id);
 
-    const std::unordered_map<Dog::Id, std::shared_ptr<Player>> &GetPlayers(const Map::Id &map_id) {
-        return players_.GetPlayers(map_id);
+    // The player leaves the game with its dog, the session is removed when its last dog leaves.
+    // Returns false if there is no player with the token
+    bool RemovePlayer(Token token);
+
+    void MovePlayer(Player &player, Direction direction) {
+        if (listener_) {
+            listener_->OnAction(player, direction);
+        }
+        player.GetSession().MoveDog(player.GetDog(), direction);
+    }
+
+    // Call fn(token, player) for every player of the game
+    template <typename Fn>
+    void ForEachPlayer(Fn &&fn) const {
+        player_tokens_.ForEachPlayer(
+            [this, &fn](Token token, Players::Handle handle) { fn(token, std::as_const(*players_.Get(handle))); });
     }
 
+    // Create the instance of the map if it doesn't exist yet; throws std::invalid_argument for an unknown map
+    GameSession &RestoreSession(const Map::Id &map_id, std::size_t instance);
+
+    // Recreate a saved player with its dog and token in the instance of the map
+    void RestorePlayer(const Map::Id &map_id, std::size_t instance, Dog::Id dog_id, std::string name, Token token,
+                       const DogStore::DogState &state);
+
     std::optional<int> GetTickPeriod() const { return tick_period_; }
 
     void SetTickPeriod(int tick_period) { tick_period_ = tick_period; }
@@ -260,75 +418,94 @@ class Game {
 
     void SetRandomizeSpawnPoint(bool randomize_spawn_points) { randomize_spawn_points_ = randomize_spawn_points; }
 
-    void Tick(double milliseconds) {
-        for (auto &[_, players] : players_) {
-            for (auto &[_, player] : players) {
-                auto [dx, dy] = player->GetDog()->GetSpeed();
-                if (dx == 0 && dy == 0) {
-                    continue;
-                }
+    // With a seed set every session gets its own reproducible random stream
+    void SetRandomSeed(std::uint64_t random_seed) { random_seed_ = random_seed; }
 
-                auto [x, y] = player->GetDog()->GetPosition();
-                auto current_point = Point{static_cast<int>(std::round(x)), static_cast<int>(std::round(y))};
-                auto [point_x, point_y] = current_point;
-
-                auto map = player->GetSession().GetMap();
-
-                auto road = map.GetPointsToRoads()
-                                .at(dx != 0 ? Orientation::HORIZONTAL : Orientation::VERTICAL)
-                                .at(current_point);
-                auto [start_x, start_y] = road->GetStart();
-                auto [end_x, end_y] = road->GetEnd();
-
-                auto need_to_stop = false;
-                auto get_new_coordinate = [&](double original_dimension, double dimension_shift, double start_dimension,
-                                              double end_dimension) {
-                    auto new_coordinate = original_dimension + dimension_shift;
-                    if (dimension_shift > 0) {
-                        if (new_coordinate > (end_dimension + 0.4)) {
-                            need_to_stop = true;
-                            return end_dimension + 0.4;
-                        }
-                    } else if (dimension_shift < 0) {
-                        if (new_coordinate < (start_dimension - 0.4)) {
-                            need_to_stop = true;
-                            return start_dimension - 0.4;
-                        }
-                    }
-                    return new_coordinate;
-                };
-
-                if (dx == 0) {
-                    y = get_new_coordinate(y, dy * (milliseconds / 1000.0), start_y, end_y);
-                } else if (dy == 0) {
-                    x = get_new_coordinate(x, dx * (milliseconds / 1000.0), start_x, end_x);
-                }
-                if (need_to_stop) {
-                    player->GetDog()->SetSpeed({0, 0});
-                }
+    // Seed for the generator of the instance of the map
+    std::uint64_t GetSessionSeed(const Map::Id &id, std::size_t instance) const;
 
-                player->GetDog()->SetPosition({x, y});
-            }
+    // Sessions are ticked on the pool when it is set, otherwise on the calling thread
+    void SetTickPool(std::shared_ptr<util::WorkerPool> tick_pool) { tick_pool_ = std::move(tick_pool); }
+
+    // Returns after every session has been ticked
+    void Tick(double milliseconds);
+
+    // Issue tokens signed with the key instead of random ones, the nonce of the tokens is random until it is restored
+    void SetTokenKey(std::string_view key) {
+        std::random_device random_device;
+        // Zero means no nonce in the saved state
+        std::uniform_int_distribution<std::uint64_t> dist(1);
+        token_signer_.emplace(key, dist(random_device));
+    }
+
+    // Tokens of the restored players were signed with the nonce of the saved game
+    void RestoreTokenNonce(std::uint64_t nonce) {
+        if (token_signer_) {
+            token_signer_->SetNonce(nonce);
         }
     }
 
+    // nullptr if tokens are random. The signer doesn't change after the start, so it may be used on any thread
+    const TokenSigner *GetTokenSigner() const noexcept { return token_signer_ ? &*token_signer_ : nullptr; }
+
+    // Digits after the point of coordinates and speeds in the API responses;
+    // without it numbers are written in the shortest form which reads back exactly
+    void SetCoordinatePrecision(int precision) { coordinate_precision_ = precision; }
+
+    std::optional<int> GetCoordinatePrecision() const noexcept { return coordinate_precision_; }
+
+    // Changes restored from snapshots and journals are not passed to the listener
+    void SetListener(std::shared_ptr<GameListener> listener) { listener_ = std::move(listener); }
+
   private:
     using MapIdToIndex = std::unordered_map<Map::Id, size_t>;
 
+    // Min-heap of the sessions which aren't full by their number of players. A join only makes the entry lag
+    // behind its session, it is brought up to date when it reaches the top and dropped once the session is full.
+    // A session which loses a player gets a new entry with a new stamp, a removed one gets a new stamp only,
+    // so their older entries are dropped when they reach the top
+    struct Placement {
+        struct Entry {
+            std::size_t players;
+            std::size_t instance;
+            std::uint64_t stamp;
+
+            auto operator<=>(const Entry &) const = default;
+        };
+
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+        // Stamp of the current entry of every instance
+        std::vector<std::uint64_t> stamps;
+        std::uint64_t next_stamp = 0;
+        // Every instance below it is open
+        std::size_t first_free = 0;
+    };
+
+    // Add the current entry of the open session to the heap of the map
+    void OfferSession(MapHandle map, std::size_t instance);
+
     void AddMap(Map &&map);
 
     std::vector<Map> maps_;
     MapIdToIndex map_id_to_index_;
-    std::vector<GameSession> sessions_;
+    // Instances of every map indexed by map handle; a removed instance leaves an empty slot
+    std::vector<std::vector<std::unique_ptr<GameSession>>> sessions_;
+    // Sessions of every map a new player may join
+    std::vector<Placement> placements_;
     Players players_;
     PlayerTokens player_tokens_;
     std::optional<int> tick_period_;
-    bool randomize_spawn_points_;
+    bool randomize_spawn_points_ = false;
+    std::optional<std::uint64_t> random_seed_;
+    std::shared_ptr<util::WorkerPool> tick_pool_;
+    std::shared_ptr<GameListener> listener_;
+    std::optional<TokenSigner> token_signer_;
+    std::optional<int> coordinate_precision_;
 };
 
 // Deserialize json value to game structure
 Game tag_invoke(value_to_tag<Game>, const value &value);
-// Serialize maps to json value
-void tag_invoke(value_from_tag, value &value, const Game::Maps &maps);
+// Write the list of maps to json stream
+void WriteJson(util::JsonWriter &writer, const Game::Maps &maps);
 
 } // namespace model
\ No newline at end of file
@@ -6,12 +6,13 @@ std::string to_string(boost::json::string string) { return {string.begin(), stri
 
 namespace model {
 
-void tag_invoke(value_from_tag, value &value, const Road &road) {
+void WriteJson(util::JsonWriter &writer, const Road &road) {
     const auto [start_x, start_y] = road.GetStart();
     const auto [end_x, end_y] = road.GetEnd();
     bool is_vertical = road.IsVertical();
 
-    value = {{"x0"sv, start_x}, {"y0"sv, start_y}, {is_vertical ? "y1"sv : "x1"sv, is_vertical ? end_y : end_x}};
+    writer.BeginObject().Key("x0"sv).Number(start_x).Key("y0"sv).Number(start_y);
+    writer.Key(is_vertical ? "y1"sv : "x1"sv).Number(is_vertical ? end_y : end_x).EndObject();
 }
 
 Road tag_invoke(value_to_tag<Road>, const value &value) {
@@ -29,10 +30,11 @@ Road tag_invoke(value_to_tag<Road>, const value &value) {
     }
 }
 
-void tag_invoke(value_from_tag, value &value, const Building &building) {
+void WriteJson(util::JsonWriter &writer, const Building &building) {
     const auto [position, size] = building.GetBounds();
 
-    value = {{"x"sv, position.x}, {"y"sv, position.y}, {"w"sv, size.width}, {"h"sv, size.height}};
+    writer.BeginObject().Key("x"sv).Number(position.x).Key("y"sv).Number(position.y);
+    writer.Key("w"sv).Number(size.width).Key("h"sv).Number(size.height).EndObject();
 }
 
 Building tag_invoke(value_to_tag<Building>, const value &value) {
@@ -46,13 +48,13 @@ Building tag_invoke(value_to_tag<Building>, const value &value) {
     return Building{Rectangle{Point{x, y}, Size{width, height}}};
 }
 
-void tag_invoke(value_from_tag, value &value, const Office &office) {
+void WriteJson(util::JsonWriter &writer, const Office &office) {
     const auto &id = office.GetId();
     const auto &position = office.GetPosition();
     const auto &offset = office.GetOffset();
 
-    value = {
-        {"id"sv, *id}, {"x"sv, position.x}, {"y"sv, position.y}, {"offsetX"sv, offset.dx}, {"offsetY"sv, offset.dy}};
+    writer.BeginObject().Key("id"sv).String(*id).Key("x"sv).Number(position.x).Key("y"sv).Number(position.y);
+    writer.Key("offsetX"sv).Number(offset.dx).Key("offsetY"sv).Number(offset.dy).EndObject();
 }
 
 Office tag_invoke(value_to_tag<Office>, const value &value) {
@@ -67,12 +69,30 @@ Office tag_invoke(value_to_tag<Office>, const value &value) {
     return Office{Office::Id(id), Point{x, y}, Offset{x_offset, y_offset}};
 }
 
-void tag_invoke(value_from_tag, value &value, const Map &map) {
-    value = {{"id", *map.GetId()},
-             {"name", map.GetName()},
-             {"roads", value_from(map.GetRoads())},
-             {"buildings", value_from(map.GetBuildings())},
-             {"offices", value_from(map.GetOffices())}};
+namespace {
+
+template <typename Items>
+void WriteArray(util::JsonWriter &writer, const Items &items) {
+    writer.BeginArray();
+    for (const auto &item : items) {
+        WriteJson(writer, item);
+    }
+    writer.EndArray();
+}
+
+} // namespace
+
+void WriteJson(util::JsonWriter &writer, const Map &map) {
+    writer.BeginObject();
+    writer.Key("id").String(*map.GetId());
+    writer.Key("name").String(map.GetName());
+    writer.Key("roads");
+    WriteArray(writer, map.GetRoads());
+    writer.Key("buildings");
+    WriteArray(writer, map.GetBuildings());
+    writer.Key("offices");
+    WriteArray(writer, map.GetOffices());
+    writer.EndObject();
 }
 
 Map tag_invoke(value_to_tag<Map>, const value &value) {
@@ -87,10 +107,58 @@ Map tag_invoke(value_to_tag<Map>, const value &value) {
     if (obj.contains("dogSpeed")) {
         map.SetDogSpeed(obj.at("dogSpeed").as_double());
     }
+    if (obj.contains("maxPlayers")) {
+        map.SetMaxPlayers(value_to<std::size_t>(obj.at("maxPlayers")));
+    }
 
     return map;
 }
 
+void Map::SetMaxPlayers(std::size_t max_players) {
+    if (max_players < 1) {
+        throw std::invalid_argument("Map "s + *id_ + " must allow at least one player in a session"s);
+    }
+    max_players_ = max_players;
+}
+
+std::optional<RoadIndex::RoadIndexType> Map::FindRoad(Point point, Orientation orientation, bool forward) const {
+    std::optional<RoadIndex::RoadIndexType> result;
+    Real farthest{};
+    road_index_.ForEachRoad(point, orientation, [&](RoadIndex::RoadIndexType road) {
+        auto [min, max] = GetRoadSpan(road);
+        const Real reach = forward ? max : -min;
+        if (!result || reach > farthest) {
+            result = road;
+            farthest = reach;
+        }
+    });
+    return result;
+}
+
+std::pair<Real, Real> Map::GetRoadSpan(RoadIndex::RoadIndexType road) const {
+    auto [start_x, start_y] = roads_[road].GetStart();
+    auto [end_x, end_y] = roads_[road].GetEnd();
+    const bool horizontal = roads_[road].IsHorizontal();
+    const Coord start = horizontal ? start_x : start_y, end = horizontal ? end_x : end_y;
+    return {std::min(start, end) - road_half_width, std::max(start, end) + road_half_width};
+}
+
+Map::Movement Map::Advance(RoadIndex::RoadIndexType road, Real coord, bool forward, Real distance) const {
+    const Real target = forward ? coord + distance : coord - distance;
+    while (true) {
+        auto [min, max] = GetRoadSpan(road);
+        if (forward ? target <= max : target >= min) {
+            return {road, target, false};
+        }
+
+        auto next = road_index_.GetNextRoad(road, forward);
+        if (!next) {
+            return {road, forward ? max : min, true};
+        }
+        road = *next;
+    }
+}
+
 void Map::AddOffice(Office &&office) {
     if (warehouse_id_to_index_.contains(office.GetId())) {
         throw std::invalid_argument("Duplicate warehouse");
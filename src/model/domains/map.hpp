@@ -1,9 +1,13 @@
 #pragma once
 
 #include <boost/json.hpp>
+#include <optional>
 #include <unordered_map>
 
 #include "basic.hpp"
+#include "road_index.hpp"
+#include "spawn_sampler.hpp"
+#include "util/json_writer.hpp"
 #include "util/tagged.hpp"
 
 namespace model {
@@ -41,8 +45,8 @@ class Road {
     Point end_;
 };
 
-// Serialize road structure to json value
-void tag_invoke(value_from_tag, value &value, const Road &road);
+// Write road structure to json stream
+void WriteJson(util::JsonWriter &writer, const Road &road);
 // Deserialize json value to road structure
 Road tag_invoke(value_to_tag<Road>, const value &value);
 
@@ -56,8 +60,8 @@ class Building {
     Rectangle bounds_;
 };
 
-// Serialize building structure to json value
-void tag_invoke(value_from_tag, value &value, const Building &building);
+// Write building structure to json stream
+void WriteJson(util::JsonWriter &writer, const Building &building);
 // Deserialize json value to building structure
 Building tag_invoke(value_to_tag<Building>, const value &value);
 
@@ -79,8 +83,8 @@ class Office {
     Offset offset_;
 };
 
-// Serialize office structure to json value
-void tag_invoke(value_from_tag, value &value, const Office &office);
+// Write office structure to json stream
+void WriteJson(util::JsonWriter &writer, const Office &office);
 // Deserialize json value to office structure
 Office tag_invoke(value_to_tag<Office>, const value &value);
 
@@ -88,14 +92,12 @@ class Map {
   public:
     using Id = util::Tagged<std::string, Map>;
     using Roads = std::vector<Road>;
-    using PointsToRoads =
-        std::unordered_map<Orientation, std::unordered_map<Point, const Road *, decltype([](const Point &point) {
-                                                               return std::hash<int>()(point.x) ^
-                                                                      std::hash<int>()(point.y);
-                                                           })>>;
     using Buildings = std::vector<Building>;
     using Offices = std::vector<Office>;
 
+    // Dogs may leave the axis of a road by this distance
+    static constexpr double road_half_width = 0.4;
+
     Map(Id id, std::string name) noexcept : id_(std::move(id)), name_(std::move(name)) {}
 
     Map(Id id, std::string name, Roads &&roads, Buildings &&buildings, Offices &&offices) noexcept
@@ -105,20 +107,8 @@ class Map {
         for (auto &&office : offices) {
             AddOffice(std::move(office));
         }
-        for (const auto &road : roads) {
-            auto current_point = road.GetStart(), end_point = road.GetEnd();
-            if (road.IsHorizontal()) {
-                while (current_point.x <= end_point.x) {
-                    point_to_road_[Orientation::HORIZONTAL][current_point] = &road;
-                    current_point.x += 1;
-                }
-            } else if (road.IsVertical()) {
-                while (current_point.y <= end_point.y) {
-                    point_to_road_[Orientation::VERTICAL][current_point] = &road;
-                    current_point.y += 1;
-                }
-            }
-        }
+        road_index_ = RoadIndex{roads_};
+        spawn_sampler_ = SpawnSampler{roads_};
     }
 
     const Id &GetId() const noexcept { return id_; }
@@ -129,13 +119,39 @@ class Map {
 
     const Roads &GetRoads() const noexcept { return roads_; }
 
-    const PointsToRoads &GetPointsToRoads() const noexcept { return point_to_road_; }
+    const RoadIndex &GetRoadIndex() const noexcept { return road_index_; }
+
+    // Built once with the map, points of long roads are as likely as points of short ones
+    const SpawnSampler &GetSpawnSampler() const noexcept { return spawn_sampler_; }
+
+    // Road of the orientation containing the point which reaches farthest in the direction of movement;
+    // forward is the direction of the growing coordinate
+    std::optional<RoadIndex::RoadIndexType> FindRoad(Point point, Orientation orientation, bool forward) const;
+
+    // Range of the coordinate along the road axis a dog may take without leaving the road
+    std::pair<Real, Real> GetRoadSpan(RoadIndex::RoadIndexType road) const;
+
+    struct Movement {
+        RoadIndex::RoadIndexType road;
+        Real coord;
+        bool stopped;
+    };
+
+    // Move a dog by distance along the road axis continuing onto collinear roads at their ends.
+    // Stops the dog at the end of the last road; costs O(number of roads crossed)
+    Movement Advance(RoadIndex::RoadIndexType road, Real coord, bool forward, Real distance) const;
 
     const Offices &GetOffices() const noexcept { return offices_; }
 
     void SetDogSpeed(double dog_speed) { dog_speed_ = dog_speed; }
 
-    std::optional<double> GetDogSpeed() { return dog_speed_; }
+    std::optional<double> GetDogSpeed() const { return dog_speed_; }
+
+    // Players of one session of the map; without the limit the map has a single session.
+    // Throws std::invalid_argument if the limit is zero
+    void SetMaxPlayers(std::size_t max_players);
+
+    std::optional<std::size_t> GetMaxPlayers() const { return max_players_; }
 
   private:
     using OfficeIdToIndex = std::unordered_map<Office::Id, size_t>;
@@ -145,16 +161,18 @@ class Map {
     Id id_;
     std::string name_;
     Roads roads_;
-    PointsToRoads point_to_road_;
+    RoadIndex road_index_;
+    SpawnSampler spawn_sampler_;
     Buildings buildings_;
     std::optional<double> dog_speed_;
+    std::optional<std::size_t> max_players_;
 
     OfficeIdToIndex warehouse_id_to_index_;
     Offices offices_;
 };
 
-// Serialize map structure to json value
-void tag_invoke(value_from_tag, value &value, const Map &map);
+// Write map structure to json stream
+void WriteJson(util::JsonWriter &writer, const Map &map);
 // Deserialize json value to map structure
 Map tag_invoke(value_to_tag<Map>, const value &value);
 
@@ -0,0 +1,87 @@
+#include "road_index.hpp"
+
+#include <tuple>
+
+#include "map.hpp"
+
+namespace model {
+
+namespace {
+
+using RoadInterval = std::tuple<Coord, Coord, RoadIndex::RoadIndexType>;
+
+// For every interval find the one which starts not after its end and ends farthest beyond it.
+// Intervals must belong to one line and be sorted by start
+void LinkForward(const std::vector<RoadInterval> &intervals, std::vector<RoadIndex::RoadIndexType> &next_roads) {
+    // The interval with the maximal end among the first i + 1 intervals
+    std::vector<std::size_t> farthest(intervals.size());
+    for (std::size_t i = 0; i < intervals.size(); ++i) {
+        const bool keep = i != 0 && std::get<1>(intervals[farthest[i - 1]]) >= std::get<1>(intervals[i]);
+        farthest[i] = keep ? farthest[i - 1] : i;
+    }
+
+    auto starts_after = [](Coord value, const RoadInterval &interval) { return value < std::get<0>(interval); };
+    for (const auto &[start, end, road] : intervals) {
+        auto last = std::upper_bound(intervals.begin(), intervals.end(), end, starts_after);
+        const auto &candidate = intervals[farthest[last - intervals.begin() - 1]];
+        if (std::get<1>(candidate) > end) {
+            next_roads[road] = std::get<2>(candidate);
+        }
+    }
+}
+
+} // namespace
+
+RoadIndex::RoadIndex(const std::vector<Road> &roads) {
+    // (line, start, end, road) for every road of both orientations
+    std::array<std::vector<std::tuple<Coord, Coord, Coord, RoadIndexType>>, 2> sorted;
+    for (RoadIndexType i = 0; i < roads.size(); ++i) {
+        const auto &road = roads[i];
+        auto [start_x, start_y] = road.GetStart();
+        auto [end_x, end_y] = road.GetEnd();
+        if (road.IsHorizontal()) {
+            sorted[static_cast<std::size_t>(Orientation::HORIZONTAL)].emplace_back(start_y, std::min(start_x, end_x),
+                                                                                 std::max(start_x, end_x), i);
+        } else {
+            sorted[static_cast<std::size_t>(Orientation::VERTICAL)].emplace_back(start_x, std::min(start_y, end_y),
+                                                                               std::max(start_y, end_y), i);
+        }
+    }
+
+    for (auto &next_roads : next_roads_) {
+        next_roads.assign(roads.size(), no_road);
+    }
+
+    for (std::size_t orientation = 0; orientation < sorted.size(); ++orientation) {
+        auto &roads_of_orientation = sorted[orientation];
+        auto &lines = lines_[orientation];
+        std::sort(roads_of_orientation.begin(), roads_of_orientation.end());
+
+        lines.intervals.reserve(roads_of_orientation.size());
+        for (const auto &[line, start, end, road] : roads_of_orientation) {
+            if (lines.coords.empty() || lines.coords.back() != line) {
+                lines.coords.push_back(line);
+                lines.offsets.push_back(lines.intervals.size());
+            }
+            const bool same_line = lines.offsets.back() != lines.intervals.size();
+            const Coord max_end = same_line ? std::max(lines.intervals.back().max_end, end) : end;
+            lines.intervals.push_back(Interval{start, end, max_end, road});
+        }
+        lines.offsets.push_back(lines.intervals.size());
+
+        for (std::size_t line = 0; line + 1 < lines.offsets.size(); ++line) {
+            std::vector<RoadInterval> forward, backward;
+            for (auto i = lines.offsets[line]; i < lines.offsets[line + 1]; ++i) {
+                const auto &interval = lines.intervals[i];
+                forward.emplace_back(interval.start, interval.end, interval.road);
+                // Moving backwards is moving forwards along the mirrored line
+                backward.emplace_back(-interval.end, -interval.start, interval.road);
+            }
+            std::sort(backward.begin(), backward.end());
+            LinkForward(forward, next_roads_[1]);
+            LinkForward(backward, next_roads_[0]);
+        }
+    }
+}
+
+} // namespace model
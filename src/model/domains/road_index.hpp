@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "basic.hpp"
+
+namespace model {
+
+class Road;
+
+// Index answering which roads of an orientation contain a point.
+// Roads are grouped by the line they lie on (y for horizontal roads, x for vertical ones);
+// every line keeps its roads as intervals sorted by start, so memory is proportional to the
+// number of roads and a lookup is two binary searches.
+// The index also links every road end to the collinear road a dog continues onto there.
+class RoadIndex {
+  public:
+    using RoadIndexType = std::size_t;
+
+    static constexpr RoadIndexType no_road = std::numeric_limits<RoadIndexType>::max();
+
+    RoadIndex() = default;
+    explicit RoadIndex(const std::vector<Road> &roads);
+
+    // Call fn with the index of every road of the orientation containing the point
+    template <typename Fn>
+    void ForEachRoad(Point point, Orientation orientation, Fn &&fn) const {
+        const auto &lines = lines_[static_cast<std::size_t>(orientation)];
+        const Coord line = orientation == Orientation::HORIZONTAL ? point.y : point.x;
+        const Coord position = orientation == Orientation::HORIZONTAL ? point.x : point.y;
+
+        auto line_it = std::lower_bound(lines.coords.begin(), lines.coords.end(), line);
+        if (line_it == lines.coords.end() || *line_it != line) {
+            return;
+        }
+        const std::size_t line_index = line_it - lines.coords.begin();
+        const auto first = lines.intervals.begin() + lines.offsets[line_index];
+        const auto last = lines.intervals.begin() + lines.offsets[line_index + 1];
+
+        // Intervals starting after the point can't contain it; walk the rest backwards while some
+        // earlier interval may still reach the point
+        auto it = std::upper_bound(first, last, position,
+                                   [](Coord value, const Interval &interval) { return value < interval.start; });
+        while (it != first) {
+            --it;
+            if (it->max_end < position) {
+                break;
+            }
+            if (it->end >= position) {
+                fn(it->road);
+            }
+        }
+    }
+
+    bool Contains(Point point, Orientation orientation) const {
+        bool found = false;
+        ForEachRoad(point, orientation, [&found](RoadIndexType) { found = true; });
+        return found;
+    }
+
+    // Collinear road touching or overlapping the end of the road (its start if forward is false)
+    // and reaching farthest beyond it
+    std::optional<RoadIndexType> GetNextRoad(RoadIndexType road, bool forward) const {
+        const auto next = next_roads_[forward ? 1 : 0][road];
+        return next == no_road ? std::nullopt : std::optional{next};
+    }
+
+  private:
+    struct Interval {
+        Coord start, end;
+        // Maximal end among this and all previous intervals of the line
+        Coord max_end;
+        RoadIndexType road;
+    };
+
+    struct Lines {
+        // Sorted line coordinates; intervals of the line i are [offsets[i], offsets[i + 1])
+        std::vector<Coord> coords;
+        std::vector<std::size_t> offsets;
+        std::vector<Interval> intervals;
+    };
+
+    std::array<Lines, 2> lines_;
+    // Next road of every road backwards and forwards along its line
+    std::array<std::vector<RoadIndexType>, 2> next_roads_;
+};
+
+} // namespace model
@@ -0,0 +1,56 @@
+#include "spawn_sampler.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "map.hpp"
+
+namespace model {
+
+SpawnSampler::SpawnSampler(const std::vector<Road> &roads) {
+    segments_.reserve(roads.size());
+    for (const auto &road : roads) {
+        const auto start = road.GetStart(), end = road.GetEnd();
+        const Point lesser{std::min(start.x, end.x), std::min(start.y, end.y)};
+        const auto length = road.IsHorizontal() ? std::max(start.x, end.x) - lesser.x
+                                                : std::max(start.y, end.y) - lesser.y;
+        segments_.push_back({lesser, static_cast<std::uint64_t>(length) + 1, road.IsHorizontal()});
+    }
+
+    // Vose's construction in integers: the weight of a segment is scaled by the number of columns,
+    // so a column is full when its weight reaches the total number of points
+    const std::uint64_t size = segments_.size();
+    std::uint64_t total = 0;
+    std::vector<std::uint64_t> scaled(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        total += segments_[i].points;
+        scaled[i] = segments_[i].points * size;
+    }
+
+    std::vector<std::size_t> small, large;
+    for (std::size_t i = 0; i < size; ++i) {
+        (scaled[i] < total ? small : large).push_back(i);
+    }
+
+    columns_.resize(size);
+    while (!small.empty() && !large.empty()) {
+        const auto less = small.back(), more = large.back();
+        small.pop_back();
+        const auto threshold = (static_cast<unsigned __int128>(scaled[less]) << 64) / total;
+        columns_[less] = {static_cast<std::uint64_t>(threshold), less, more};
+
+        scaled[more] -= total - scaled[less];
+        if (scaled[more] < total) {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+    // What is left is full up to rounding
+    for (auto list : {&small, &large}) {
+        for (auto i : *list) {
+            columns_[i] = {std::numeric_limits<std::uint64_t>::max(), i, i};
+        }
+    }
+}
+
+} // namespace model
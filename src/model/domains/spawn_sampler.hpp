@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "basic.hpp"
+
+namespace model {
+
+class Road;
+
+// Picks a random integer point of the roads of a map, every point equally likely.
+// A road is chosen with probability proportional to the number of its points by Walker's alias method,
+// so a sample costs three draws of the generator and no allocations whatever the number of roads is
+class SpawnSampler {
+  public:
+    SpawnSampler() = default;
+    explicit SpawnSampler(const std::vector<Road> &roads);
+
+    // Generator must produce uniformly distributed 64-bit values, e.g. std::mt19937_64.
+    // Its raw output is mapped to the point with integer arithmetic only, unlike the standard distributions
+    // whose algorithms are up to the library, so a seed gives the same points on any machine
+    template <typename Generator>
+    Point Sample(Generator &generator) const {
+        static_assert(Generator::min() == 0 && Generator::max() == std::numeric_limits<std::uint64_t>::max(),
+                      "Samples are mapped from the full range of 64-bit values");
+        const auto &column = columns_[Below(generator(), columns_.size())];
+        const auto &segment = segments_[generator() < column.threshold ? column.segment : column.alias];
+        const auto offset = static_cast<Coord>(Below(generator(), segment.points));
+        return segment.horizontal ? Point{segment.start.x + offset, segment.start.y}
+                                  : Point{segment.start.x, segment.start.y + offset};
+    }
+
+  private:
+    // Road with its start moved to the lesser end
+    struct Segment {
+        Point start;
+        std::uint64_t points;
+        bool horizontal;
+    };
+
+    // Draws below threshold pick the segment of the column, the others pick its alias
+    struct Column {
+        std::uint64_t threshold;
+        std::size_t segment;
+        std::size_t alias;
+    };
+
+    // Map a uniform 64-bit value to [0, bound) without division
+    static std::uint64_t Below(std::uint64_t value, std::uint64_t bound) noexcept {
+        return static_cast<std::uint64_t>((static_cast<unsigned __int128>(value) * bound) >> 64);
+    }
+
+    std::vector<Segment> segments_;
+    std::vector<Column> columns_;
+};
+
+} // namespace model
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "util/sha256.hpp"
+
+namespace model {
+
+// 128-bit authorization token. Clients see it as 32 lowercase hex digits;
+// encoding and decoding don't allocate
+class Token {
+  public:
+    static constexpr std::size_t hex_size = 32;
+    using Hex = std::array<char, hex_size>;
+
+    constexpr Token() noexcept = default;
+    constexpr Token(std::uint64_t high, std::uint64_t low) noexcept : high_(high), low_(low) {}
+
+    static constexpr std::optional<Token> FromHex(std::string_view hex) noexcept {
+        if (hex.size() != hex_size) {
+            return std::nullopt;
+        }
+        std::uint64_t parts[2]{};
+        for (std::size_t i = 0; i < hex_size; ++i) {
+            const int digit = HexDigit(hex[i]);
+            if (digit < 0) {
+                return std::nullopt;
+            }
+            parts[i / 16] = parts[i / 16] << 4 | static_cast<std::uint64_t>(digit);
+        }
+        return Token{parts[0], parts[1]};
+    }
+
+    constexpr Hex ToHex() const noexcept {
+        constexpr std::string_view digits = "0123456789abcdef";
+        Hex hex{};
+        for (std::size_t i = 0; i < 16; ++i) {
+            hex[15 - i] = digits[(high_ >> (4 * i)) & 0xf];
+            hex[31 - i] = digits[(low_ >> (4 * i)) & 0xf];
+        }
+        return hex;
+    }
+
+    constexpr std::uint64_t GetHigh() const noexcept { return high_; }
+
+    constexpr std::uint64_t GetLow() const noexcept { return low_; }
+
+    constexpr auto operator<=>(const Token &) const noexcept = default;
+
+  private:
+    static constexpr int HexDigit(char c) noexcept {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        return -1;
+    }
+
+    std::uint64_t high_ = 0;
+    std::uint64_t low_ = 0;
+};
+
+// Flat open-addressing table keyed by tokens with linear probing. Keys are kept apart from values,
+// so a lookup usually touches one cache line of keys and one of values.
+// The zero token marks empty slots and can't be inserted
+template <typename Value>
+class TokenTable {
+  public:
+    std::size_t Size() const noexcept { return size_; }
+
+    const Value *Find(Token token) const noexcept {
+        if (size_ == 0 || token == Token{}) {
+            return nullptr;
+        }
+        const std::size_t mask = keys_.size() - 1;
+        for (std::size_t slot = Hash(token) & mask;; slot = (slot + 1) & mask) {
+            if (keys_[slot] == token) {
+                return &values_[slot];
+            }
+            if (keys_[slot] == Token{}) {
+                return nullptr;
+            }
+        }
+    }
+
+    Value *Find(Token token) noexcept { return const_cast<Value *>(std::as_const(*this).Find(token)); }
+
+    // Returns false if the token is already in the table
+    bool Insert(Token token, Value value) {
+        if (token == Token{}) {
+            throw std::invalid_argument("Zero token can't be inserted");
+        }
+        // Load factor is kept below 1/2, so probe sequences stay short
+        if ((size_ + 1) * 2 > keys_.size()) {
+            Rehash(std::max<std::size_t>(16, keys_.size() * 2));
+        }
+        const std::size_t mask = keys_.size() - 1;
+        std::size_t slot = Hash(token) & mask;
+        for (; keys_[slot] != Token{}; slot = (slot + 1) & mask) {
+            if (keys_[slot] == token) {
+                return false;
+            }
+        }
+        keys_[slot] = token;
+        values_[slot] = std::move(value);
+        ++size_;
+        return true;
+    }
+
+    // Returns false if there is no such token. The entries following it in the probe sequence are shifted back
+    // into the freed slot, so no tombstones are left and lookups stay as short as before
+    bool Erase(Token token) {
+        if (size_ == 0 || token == Token{}) {
+            return false;
+        }
+        const std::size_t mask = keys_.size() - 1;
+        std::size_t hole = Hash(token) & mask;
+        for (; keys_[hole] != token; hole = (hole + 1) & mask) {
+            if (keys_[hole] == Token{}) {
+                return false;
+            }
+        }
+        for (std::size_t slot = (hole + 1) & mask; keys_[slot] != Token{}; slot = (slot + 1) & mask) {
+            // An entry may take the hole only if the hole is between its home slot and its current one
+            const std::size_t home = Hash(keys_[slot]) & mask;
+            if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+                keys_[hole] = keys_[slot];
+                values_[hole] = std::move(values_[slot]);
+                hole = slot;
+            }
+        }
+        keys_[hole] = Token{};
+        values_[hole] = Value{};
+        --size_;
+        return true;
+    }
+
+    // Call fn(token, value) for every entry
+    template <typename Fn>
+    void ForEach(Fn &&fn) const {
+        for (std::size_t slot = 0; slot < keys_.size(); ++slot) {
+            if (keys_[slot] != Token{}) {
+                fn(keys_[slot], values_[slot]);
+            }
+        }
+    }
+
+  private:
+    // Generated tokens are random anyway, but restored ones may be not, so both halves are mixed
+    static std::size_t Hash(Token token) noexcept {
+        const std::uint64_t hash = (token.GetHigh() ^ token.GetLow()) * 0x9e3779b97f4a7c15ull;
+        return hash ^ (hash >> 32);
+    }
+
+    void Rehash(std::size_t capacity) {
+        std::vector<Token> keys(capacity);
+        std::vector<Value> values(capacity);
+        const std::size_t mask = capacity - 1;
+        for (std::size_t old_slot = 0; old_slot < keys_.size(); ++old_slot) {
+            if (keys_[old_slot] == Token{}) {
+                continue;
+            }
+            std::size_t slot = Hash(keys_[old_slot]) & mask;
+            while (keys[slot] != Token{}) {
+                slot = (slot + 1) & mask;
+            }
+            keys[slot] = keys_[old_slot];
+            values[slot] = std::move(values_[old_slot]);
+        }
+        keys_ = std::move(keys);
+        values_ = std::move(values);
+    }
+
+    std::vector<Token> keys_;
+    std::vector<Value> values_;
+    std::size_t size_ = 0;
+};
+
+// Tokens which carry the player they were issued to, so checking them needs no lookup.
+// The high half holds the map index in its upper 16 bits and the dog id in the lower 48 bits,
+// the low half is the HMAC-SHA256 of the nonce and the high half with the server key truncated to 64 bits.
+// Dog ids start over in a game started without a saved state, so the nonce is random for every such game
+// and is saved with the state: a token of another game doesn't match a player which got the same id.
+// The signer isn't changed after the start, tokens may be verified on any thread
+class TokenSigner {
+  public:
+    static constexpr std::uint64_t max_dog_id = (std::uint64_t{1} << 48) - 1;
+
+    struct Payload {
+        std::size_t map_index;
+        std::uint64_t dog_id;
+    };
+
+    TokenSigner(std::string_view key, std::uint64_t nonce) : hmac_(key), nonce_(nonce) {}
+
+    std::uint64_t GetNonce() const noexcept { return nonce_; }
+
+    // Tokens of the restored game were signed with its nonce. Must be called before the server starts
+    void SetNonce(std::uint64_t nonce) noexcept { nonce_ = nonce; }
+
+    Token Sign(std::size_t map_index, std::uint64_t dog_id) const {
+        if (map_index > 0xffff || dog_id > max_dog_id) {
+            throw std::out_of_range("Player can't be encoded in a signed token");
+        }
+        const std::uint64_t payload = std::uint64_t{map_index} << 48 | dog_id;
+        return Token{payload, GetSignature(payload)};
+    }
+
+    std::optional<Payload> Verify(Token token) const noexcept {
+        const std::uint64_t payload = token.GetHigh();
+        const std::uint64_t expected = GetSignature(payload);
+        const std::uint64_t actual = token.GetLow();
+        if (!util::ConstantTimeEqual(reinterpret_cast<const std::uint8_t *>(&expected),
+                                     reinterpret_cast<const std::uint8_t *>(&actual), sizeof(actual))) {
+            return std::nullopt;
+        }
+        return Payload{static_cast<std::size_t>(payload >> 48), payload & max_dog_id};
+    }
+
+  private:
+    std::uint64_t GetSignature(std::uint64_t payload) const noexcept {
+        std::array<char, 16> message;
+        for (std::size_t i = 0; i < 8; ++i) {
+            message[i] = static_cast<char>(nonce_ >> (56 - 8 * i));
+            message[8 + i] = static_cast<char>(payload >> (56 - 8 * i));
+        }
+        const auto digest = hmac_.Sign({message.data(), message.size()});
+
+        std::uint64_t signature = 0;
+        for (std::size_t i = 0; i < 8; ++i) {
+            signature = signature << 8 | digest[i];
+        }
+        return signature;
+    }
+
+    util::HmacSha256 hmac_;
+    std::uint64_t nonce_;
+};
+
+} // namespace model
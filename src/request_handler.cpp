@@ -1,27 +1,41 @@
 #include "request_handler.hpp"
 
-#include "util/filesystem.hpp"
-#include "util/mime_type.hpp"
-
 namespace request_handler {
 
 // Handle static files requests
-Response RequestHandler::get_file(std::string_view target) const {
-    Response response;
-
-    auto path = GetPath(target, base_path_);
-    if (ValidatePath(path, base_path_)) {
-        auto extension = path.extension().string();
+Response RequestHandler::get_file(std::string_view target, std::string_view accept_encoding,
+                                  std::string_view if_none_match) const {
+    if (StaticCache::IsOutsideRoot(target)) {
+        return Response::Text(http::status::bad_request, "Invalid path");
+    }
+    const auto *asset = static_cache_.Find(target);
+    if (!asset) {
+        return Response::Text(http::status::not_found, "File not found");
+    }
 
+    Response response;
+    if (!asset->IsCached()) {
         boost::system::error_code ec;
-        response = Response::File(http::status::ok, GetMimeType(extension), path.string(), ec);
+        response = Response::File(http::status::ok, asset->mime_type, asset->path.string(), ec);
         if (ec)
             response = Response::Text(http::status::not_found, "File not found");
-    } else {
-        response = Response::Text(http::status::bad_request, "Invalid path");
+        return response;
     }
 
+    const auto encoding = NegotiateEncoding(*asset, accept_encoding);
+    const auto &variant = *asset->GetVariant(encoding);
+    if (MatchesETag(if_none_match, variant.etag)) {
+        response = Response::NotModified(variant.etag);
+    } else {
+        response = Response::Shared(http::status::ok, asset->mime_type, variant.body).etag(variant.etag);
+        if (encoding != ContentEncoding::IDENTITY) {
+            response.set("Content-Encoding", GetEncodingToken(encoding));
+        }
+    }
+    if (asset->IsNegotiated()) {
+        response.set("Vary", "Accept-Encoding");
+    }
     return response;
 }
 
-} // namespace request_handler
\ No newline at end of file
+} // namespace request_handler
@@ -8,7 +8,10 @@
 #include "api_handler/api_handler.hpp"
 #include "model/model.hpp"
 #include "util/logging.hpp"
+#include "util/queue_budget.hpp"
+#include "util/request_arena.hpp"
 #include "util/response.hpp"
+#include "util/static_cache.hpp"
 
 namespace request_handler {
 
@@ -25,44 +28,73 @@ class RequestHandler {
   public:
     using Strand = beast::net::strand<beast::net::io_context::executor_type>;
 
-    explicit RequestHandler(model::Game &game, std::string_view static_path, Strand api_strand)
-        : api_(game), base_path_(static_path), api_strand_(api_strand) {}
+    explicit RequestHandler(model::Game &game, std::string_view static_path, Strand api_strand,
+                            QueueBudget::Limits api_limits = {})
+        : api_(game), static_cache_(static_path), api_strand_(api_strand), api_budget_(api_limits) {}
 
     RequestHandler(const RequestHandler &) = delete;
     RequestHandler &operator=(const RequestHandler &) = delete;
 
     template <typename Body, typename Allocator, typename Send>
     void operator()(std::string_view address, http::request<Body, http::basic_fields<Allocator>> &&request,
-                    Send &&send) const {
+                    RequestArena &arena, Send &&send) const {
         auto target = request.target();
 
         LogRequest(address, target, request.method_string());
         auto start_ts = std::chrono::system_clock::now();
 
-        Response response;
-        bool is_api_request = api_.dispatch(request, response);
-        if (!is_api_request) {
-            response = get_file(target);
+        if (target.starts_with("/api/")) {
+            std::optional<model::TokenSigner::Payload> signed_player;
+            if (auto response = api_.precheck(request, signed_player)) {
+                finish(std::move(*response), request, send, start_ts);
+                return;
+            }
+
+            // Under overload the request is refused at once instead of waiting behind the others
+            if (!api_budget_.TryEnter()) {
+                finish(model::api::errors::service_unavailable(api_budget_.GetRetryAfter()), request, send, start_ts);
+                return;
+            }
+
+            // Game state is only touched on api_strand, so a tick is never observed half-done
+            // The arena belongs to the request and is reused only after the response is written,
+            // the connection is kept alive by send
+            beast::net::dispatch(api_strand_, [this, request = std::move(request), storage = arena.GetStorage(),
+                                               &output = arena.GetOutput(), signed_player,
+                                               send = std::forward<Send>(send), start_ts,
+                                               admitted = QueueBudget::Clock::now()]() mutable {
+                api_budget_.Start(admitted);
+                Response response;
+                api_.dispatch(request, storage, signed_player, output, response);
+                finish(std::move(response), request, send, start_ts);
+            });
+        } else {
+            finish(get_file(target, request[http::field::accept_encoding], request[http::field::if_none_match]),
+                   request, send, start_ts);
         }
+    }
 
+  private:
+    template <typename Request, typename Send>
+    static void finish(Response &&response, const Request &request, Send &send,
+                       std::chrono::system_clock::time_point start_ts) {
         auto end_ts = std::chrono::system_clock::now();
         LogResponse(std::chrono::duration_cast<std::chrono::milliseconds>(end_ts - start_ts).count(), response.code(),
                     response.content_type());
 
         response.finalize(request.version(), request.keep_alive());
-        if (is_api_request)
-            response.send(send, api_strand_);
-        else
-            response.send(send);
+        response.send(send);
     }
 
-  private:
     // Handle static files requests
-    Response get_file(std::string_view target) const;
+    Response get_file(std::string_view target, std::string_view accept_encoding,
+                      std::string_view if_none_match) const;
 
     api_handler::APIHandler api_;
-    fs::path base_path_;
+    StaticCache static_cache_;
     Strand api_strand_;
+    // Requests waiting for api_strand
+    mutable QueueBudget api_budget_;
 };
 
 } // namespace request_handler
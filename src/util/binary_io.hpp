@@ -0,0 +1,93 @@
+#pragma once
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace util {
+
+// Values are stored in the native byte order: files are read back only by the same build
+
+class BinaryWriter {
+  public:
+    template <typename T>
+    void Write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        buffer_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void Write(std::string_view str) { buffer_.append(str); }
+
+    std::size_t Size() const noexcept { return buffer_.size(); }
+
+    std::string_view GetData() const noexcept { return buffer_; }
+
+    std::string Take() noexcept { return std::exchange(buffer_, std::string{}); }
+
+  private:
+    std::string buffer_;
+};
+
+// Bounds-checked cursor over a buffer, throws std::runtime_error when the data is truncated
+class BinaryReader {
+  public:
+    BinaryReader(const char *data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    std::string ReadString(std::size_t size) { return std::string(Take(size), size); }
+
+    // Reader over the next size bytes
+    BinaryReader Sub(std::size_t size) { return BinaryReader{Take(size), size}; }
+
+    std::size_t Remaining() const noexcept { return size_ - offset_; }
+
+  private:
+    const char *Take(std::size_t size) {
+        if (size > Remaining()) {
+            throw std::runtime_error("Unexpected end of data");
+        }
+        const char *result = data_ + offset_;
+        offset_ += size;
+        return result;
+    }
+
+    const char *data_;
+    std::size_t size_;
+    std::size_t offset_ = 0;
+};
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+  public:
+    explicit MappedFile(const std::filesystem::path &path) {
+        // Empty files can't be mapped
+        if (std::filesystem::file_size(path) != 0) {
+            file_ = boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+            region_ = boost::interprocess::mapped_region(file_, boost::interprocess::read_only);
+        }
+    }
+
+    BinaryReader GetReader() const noexcept {
+        return BinaryReader{static_cast<const char *>(region_.get_address()), region_.get_size()};
+    }
+
+  private:
+    boost::interprocess::file_mapping file_;
+    boost::interprocess::mapped_region region_;
+};
+
+} // namespace util
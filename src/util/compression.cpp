@@ -0,0 +1,65 @@
+#include "compression.hpp"
+
+#include <brotli/encode.h>
+#include <zlib.h>
+
+#include <stdexcept>
+
+namespace util {
+
+using namespace std::literals;
+
+std::string_view GetEncodingToken(ContentEncoding encoding) {
+    switch (encoding) {
+    case ContentEncoding::GZIP:
+        return "gzip"sv;
+    case ContentEncoding::BROTLI:
+        return "br"sv;
+    default:
+        return "identity"sv;
+    }
+}
+
+std::string GzipCompress(std::string_view data) {
+    // 16 over the window bits asks zlib for the gzip header and trailer instead of the zlib ones
+    constexpr int gzip_window_bits = 15 + 16;
+    constexpr int memory_level = 8;
+
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, gzip_window_bits, memory_level, Z_DEFAULT_STRATEGY) !=
+        Z_OK) {
+        throw std::runtime_error("Failed to initialize gzip compression"s);
+    }
+
+    std::string result(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(result.data());
+    stream.avail_out = static_cast<uInt>(result.size());
+
+    // The output buffer fits the whole stream, so a single call finishes it
+    const int status = deflate(&stream, Z_FINISH);
+    result.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        throw std::runtime_error("Failed to compress data with gzip"s);
+    }
+    return result;
+}
+
+std::string BrotliCompress(std::string_view data, bool text) {
+    // The best quality takes seconds for the larger scripts, this one is close in size and much faster
+    constexpr int quality = 9;
+
+    std::string result(BrotliEncoderMaxCompressedSize(data.size()), '\0');
+    std::size_t size = result.size();
+    if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, text ? BROTLI_MODE_TEXT : BROTLI_MODE_GENERIC,
+                               data.size(), reinterpret_cast<const std::uint8_t *>(data.data()), &size,
+                               reinterpret_cast<std::uint8_t *>(result.data()))) {
+        throw std::runtime_error("Failed to compress data with brotli"s);
+    }
+    result.resize(size);
+    return result;
+}
+
+} // namespace util
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// Content codings of HTTP responses (RFC 9110, 8.4.1)
+enum class ContentEncoding { IDENTITY, GZIP, BROTLI };
+
+// Token of the coding in Content-Encoding and Accept-Encoding headers
+std::string_view GetEncodingToken(ContentEncoding encoding);
+
+// The data in gzip format with the best compression
+std::string GzipCompress(std::string_view data);
+
+// The data in brotli format; text mode tunes the encoder for UTF-8 text
+std::string BrotliCompress(std::string_view data, bool text);
+
+} // namespace util
@@ -0,0 +1,75 @@
+#include "etag.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <random>
+
+namespace util {
+
+namespace {
+
+std::string Quote(std::string_view value) {
+    std::string result;
+    result.reserve(value.size() + 2);
+    result += '"';
+    result += value;
+    result += '"';
+    return result;
+}
+
+std::string ToHex(std::uint64_t value) {
+    char buffer[16];
+    auto [end, _] = std::to_chars(buffer, buffer + sizeof(buffer), value, 16);
+    return std::string(buffer, end);
+}
+
+} // namespace
+
+std::string MakeContentETag(std::string_view content) {
+    // FNV-1a is enough to tell the versions of a document apart
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : content) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return Quote(ToHex(hash) + '-' + ToHex(content.size()));
+}
+
+std::string MakeVersionETagPrefix(std::string_view resource) {
+    std::random_device random_device;
+    std::uniform_int_distribution<std::uint64_t> dist;
+    return std::string(resource) + '-' + ToHex(dist(random_device));
+}
+
+std::string MakeVersionETag(std::string_view prefix, std::initializer_list<std::uint64_t> scope,
+                            std::uint64_t version) {
+    std::string tag(prefix);
+    for (auto part : scope) {
+        tag += '-';
+        tag += ToHex(part);
+    }
+    tag += '-';
+    tag += ToHex(version);
+    return Quote(tag);
+}
+
+bool MatchesETag(std::string_view if_none_match, std::string_view etag) {
+    constexpr std::string_view spaces = " \t";
+    while (!if_none_match.empty()) {
+        const auto comma = if_none_match.find(',');
+        auto tag = if_none_match.substr(0, comma);
+        if_none_match.remove_prefix(comma == std::string_view::npos ? if_none_match.size() : comma + 1);
+
+        tag.remove_prefix(std::min(tag.find_first_not_of(spaces), tag.size()));
+        tag.remove_suffix(tag.size() - std::min(tag.find_last_not_of(spaces) + 1, tag.size()));
+        // If-None-Match uses the weak comparison
+        if (tag.starts_with("W/")) {
+            tag.remove_prefix(2);
+        }
+        if (tag == "*" || tag == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace util
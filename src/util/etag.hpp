@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace util {
+
+// Strong entity tag derived from the content
+std::string MakeContentETag(std::string_view content);
+
+// Prefix of the version tags of the resource. Versions start over when the server restarts,
+// so the prefix contains a random part to tell the tags of different runs apart
+std::string MakeVersionETagPrefix(std::string_view resource);
+
+// Strong entity tag derived from a version of a resource. Scope tells apart the resources served on one URL
+// whose versions are counted separately, e.g. the state of different sessions
+std::string MakeVersionETag(std::string_view prefix, std::initializer_list<std::uint64_t> scope,
+                            std::uint64_t version);
+
+// Whether the value of an If-None-Match header matches the tag
+bool MatchesETag(std::string_view if_none_match, std::string_view etag);
+
+// Immutable serialized document shared by the responses
+struct Document {
+    explicit Document(std::string content)
+        : body(std::make_shared<const std::string>(std::move(content))), etag(MakeContentETag(*body)) {}
+
+    std::shared_ptr<const std::string> body;
+    std::string etag;
+};
+
+} // namespace util
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <limits>
+
+namespace util {
+
+/**
+ * Число с фиксированной точкой: целое количество 1/2^FractionBits долей единицы.
+ * Вся арифметика целочисленная, поэтому результат не зависит от машины и флагов компиляции.
+ * Пример:
+ *
+ *  using Coord = util::FixedPoint<10>; // 1/1024 единицы
+ *  Coord x = 2.5;
+ *  x = x + Coord{0.25};
+ *  static_cast<double>(x); // 2.75
+ */
+template <int FractionBits>
+class FixedPoint {
+  public:
+    using Raw = std::int64_t;
+
+    static constexpr Raw one = Raw{1} << FractionBits;
+
+    constexpr FixedPoint() = default;
+
+    // Rounds to the nearest representable value
+    FixedPoint(double value) : raw_(std::llround(value * one)) {}
+
+    static constexpr FixedPoint FromRaw(Raw raw) {
+        FixedPoint result;
+        result.raw_ = raw;
+        return result;
+    }
+
+    constexpr Raw GetRaw() const { return raw_; }
+
+    explicit constexpr operator double() const { return static_cast<double>(raw_) / one; }
+
+    constexpr FixedPoint operator-() const { return FromRaw(-raw_); }
+
+    friend constexpr FixedPoint operator+(FixedPoint lhs, FixedPoint rhs) { return FromRaw(lhs.raw_ + rhs.raw_); }
+
+    friend constexpr FixedPoint operator-(FixedPoint lhs, FixedPoint rhs) { return FromRaw(lhs.raw_ - rhs.raw_); }
+
+    friend constexpr FixedPoint abs(FixedPoint value) { return FromRaw(value.raw_ < 0 ? -value.raw_ : value.raw_); }
+
+    auto operator<=>(const FixedPoint &) const = default;
+
+  private:
+    Raw raw_ = 0;
+};
+
+} // namespace util
+
+template <int FractionBits>
+struct std::numeric_limits<util::FixedPoint<FractionBits>> {
+    using Type = util::FixedPoint<FractionBits>;
+
+    static constexpr bool is_specialized = true;
+
+    static constexpr Type lowest() { return Type::FromRaw(std::numeric_limits<typename Type::Raw>::lowest()); }
+    static constexpr Type max() { return Type::FromRaw(std::numeric_limits<typename Type::Raw>::max()); }
+};
@@ -0,0 +1,85 @@
+#include "json_writer.hpp"
+
+#include <array>
+#include <charconv>
+#include <cmath>
+
+namespace util {
+
+namespace {
+
+// Characters which can't appear in a JSON string as is
+constexpr bool NeedsEscape(unsigned char c) noexcept { return c < 0x20 || c == '"' || c == '\\'; }
+
+} // namespace
+
+JsonWriter &JsonWriter::Number(double value) {
+    Separate();
+    // JSON has no infinities and NaNs
+    if (!std::isfinite(value)) {
+        out_ += "null";
+        return *this;
+    }
+
+    std::array<char, 64> buffer;
+    auto result = precision_
+                      ? std::to_chars(buffer.data(), buffer.data() + buffer.size(), value, std::chars_format::fixed,
+                                      *precision_)
+                      : std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+    if (result.ec != std::errc{}) {
+        // Too many digits for the buffer, only possible for huge numbers in the fixed form
+        result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+    }
+    out_.append(buffer.data(), result.ptr);
+    return *this;
+}
+
+void JsonWriter::WriteString(std::string_view value) {
+    static constexpr std::string_view hex = "0123456789abcdef";
+
+    out_ += '"';
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        const auto c = static_cast<unsigned char>(value[i]);
+        if (!NeedsEscape(c)) {
+            continue;
+        }
+        out_.append(value.data() + begin, i - begin);
+        begin = i + 1;
+        switch (c) {
+        case '"':
+            out_ += "\\\"";
+            break;
+        case '\\':
+            out_ += "\\\\";
+            break;
+        case '\n':
+            out_ += "\\n";
+            break;
+        case '\r':
+            out_ += "\\r";
+            break;
+        case '\t':
+            out_ += "\\t";
+            break;
+        default:
+            out_ += "\\u00";
+            out_ += hex[c >> 4];
+            out_ += hex[c & 0xf];
+        }
+    }
+    out_.append(value.data() + begin, value.size() - begin);
+    out_ += '"';
+}
+
+void JsonWriter::WriteInteger(std::int64_t value) {
+    std::array<char, 20> buffer;
+    out_.append(buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), value).ptr);
+}
+
+void JsonWriter::WriteInteger(std::uint64_t value) {
+    std::array<char, 20> buffer;
+    out_.append(buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), value).ptr);
+}
+
+} // namespace util
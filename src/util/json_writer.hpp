@@ -0,0 +1,115 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace util {
+
+// Writes JSON text straight into a string without building a document.
+// Commas and colons are placed by the writer, the caller keeps objects and arrays balanced
+class JsonWriter {
+  public:
+    // Precision is the number of digits after the point of floating-point numbers;
+    // without it a number is written in the shortest form which reads back exactly
+    explicit JsonWriter(std::string &out, std::optional<int> precision = std::nullopt) noexcept
+        : out_(out), precision_(precision) {}
+
+    // Expect about size more bytes of output
+    void Reserve(std::size_t size) { out_.reserve(out_.size() + size); }
+
+    JsonWriter &BeginObject() { return Open('{'); }
+
+    JsonWriter &EndObject() { return Close('}'); }
+
+    JsonWriter &BeginArray() { return Open('['); }
+
+    JsonWriter &EndArray() { return Close(']'); }
+
+    // The next call writes the value of the member
+    JsonWriter &Key(std::string_view key) {
+        Separate();
+        WriteString(key);
+        out_ += ':';
+        first_ = true;
+        return *this;
+    }
+
+    JsonWriter &String(std::string_view value) {
+        Separate();
+        WriteString(value);
+        return *this;
+    }
+
+    template <std::integral T>
+        requires(!std::same_as<T, bool>)
+    JsonWriter &Number(T value) {
+        Separate();
+        if constexpr (std::is_signed_v<T>) {
+            WriteInteger(static_cast<std::int64_t>(value));
+        } else {
+            WriteInteger(static_cast<std::uint64_t>(value));
+        }
+        return *this;
+    }
+
+    JsonWriter &Number(double value);
+
+    JsonWriter &Bool(bool value) {
+        Separate();
+        out_ += value ? "true" : "false";
+        return *this;
+    }
+
+  private:
+    JsonWriter &Open(char bracket) {
+        Separate();
+        out_ += bracket;
+        first_ = true;
+        return *this;
+    }
+
+    JsonWriter &Close(char bracket) {
+        out_ += bracket;
+        first_ = false;
+        return *this;
+    }
+
+    void Separate() {
+        if (!first_) {
+            out_ += ',';
+        }
+        first_ = false;
+    }
+
+    void WriteString(std::string_view value);
+    void WriteInteger(std::int64_t value);
+    void WriteInteger(std::uint64_t value);
+
+    std::string &out_;
+    std::optional<int> precision_;
+    bool first_ = true;
+};
+
+// JSON text of a value which has an overload of WriteJson(JsonWriter &, const T &)
+template <typename T>
+std::string ToJson(const T &value, std::optional<int> precision = std::nullopt) {
+    std::string out;
+    JsonWriter writer{out, precision};
+    WriteJson(writer, value);
+    return out;
+}
+
+// Writes the JSON text into the buffer, e.g. the output of util::RequestArena, replacing its content
+template <typename T>
+std::string_view ToJson(const T &value, std::string &out, std::optional<int> precision = std::nullopt) {
+    out.clear();
+    JsonWriter writer{out, precision};
+    WriteJson(writer, value);
+    return out;
+}
+
+} // namespace util
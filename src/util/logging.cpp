@@ -51,4 +51,9 @@ void LogError(int code, std::string_view text, std::string_view where) {
     BOOST_LOG_TRIVIAL(info) << boost::log::add_value(additional_data, custom_data) << "error";
 }
 
+void LogJournalReplayed(std::size_t records, int replay_time) {
+    boost::json::value custom_data{{"records", records}, {"replay_time", replay_time}};
+    BOOST_LOG_TRIVIAL(info) << boost::log::add_value(additional_data, custom_data) << "journal replayed";
+}
+
 } // namespace util
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <boost/log/core/record_view.hpp>
 #include <boost/log/utility/formatting_ostream_fwd.hpp>
 
+#include <cstddef>
+#include <string_view>
+
 namespace util {
 
 void LogFormatter(const boost::log::record_view &rec, boost::log::formatting_ostream &stream);
@@ -13,5 +16,6 @@ void LogExit(int code, std::string_view exception);
 void LogRequest(std::string_view address, std::string_view uri, std::string_view method);
 void LogResponse(int response_time, int code, std::string_view content_type);
 void LogError(int code, std::string_view text, std::string_view where);
+void LogJournalReplayed(std::size_t records, int replay_time);
 
 } // namespace util
\ No newline at end of file
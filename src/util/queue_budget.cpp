@@ -0,0 +1,36 @@
+#include "queue_budget.hpp"
+
+#include <algorithm>
+
+namespace util {
+
+bool QueueBudget::TryEnter() noexcept {
+    auto depth = depth_.load(std::memory_order_relaxed);
+    do {
+        if (limits_.max_depth && depth >= *limits_.max_depth) {
+            return false;
+        }
+        if (limits_.max_delay && depth != 0 &&
+            std::chrono::microseconds{delay_.load(std::memory_order_relaxed)} > *limits_.max_delay) {
+            return false;
+        }
+    } while (!depth_.compare_exchange_weak(depth, depth + 1, std::memory_order_relaxed));
+    return true;
+}
+
+void QueueBudget::Start(Clock::time_point admitted) noexcept {
+    // Each wait moves the average by an eighth of the difference
+    constexpr std::int64_t smoothing = 8;
+
+    depth_.fetch_sub(1, std::memory_order_relaxed);
+    const auto wait = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - admitted).count();
+    const auto delay = delay_.load(std::memory_order_relaxed);
+    delay_.store(delay + (wait - delay) / smoothing, std::memory_order_relaxed);
+}
+
+std::chrono::seconds QueueBudget::GetRetryAfter() const noexcept {
+    const auto delay = std::chrono::microseconds{delay_.load(std::memory_order_relaxed)};
+    return std::max(std::chrono::seconds{1}, std::chrono::ceil<std::chrono::seconds>(delay));
+}
+
+} // namespace util
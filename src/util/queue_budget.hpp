@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace util {
+
+// Admission control of a queue of tasks run one at a time, e.g. on a strand.
+// A task is admitted while the queue is shorter than the depth limit and tasks wait in it less than
+// the delay limit, so the latency of the admitted tasks stays bounded; the others are rejected right away.
+// The delay is a moving average of the measured waits; an empty queue always admits, so a stale estimate
+// doesn't keep rejecting after the load has gone
+class QueueBudget {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Limits {
+        std::optional<std::size_t> max_depth;
+        std::optional<std::chrono::milliseconds> max_delay;
+    };
+
+    explicit QueueBudget(Limits limits = {}) noexcept : limits_(limits) {}
+
+    // May be called from any thread; an admitted task must call Start when it begins running
+    bool TryEnter() noexcept;
+
+    // Called by the task with the time it was admitted, only from the queue
+    void Start(Clock::time_point admitted) noexcept;
+
+    // Time after which a rejected client may retry, at least a second
+    std::chrono::seconds GetRetryAfter() const noexcept;
+
+  private:
+    Limits limits_;
+    std::atomic<std::size_t> depth_{0};
+    // Moving average of the wait in the queue in microseconds
+    std::atomic<std::int64_t> delay_{0};
+};
+
+} // namespace util
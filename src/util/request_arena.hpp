@@ -0,0 +1,79 @@
+#pragma once
+
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace util {
+
+// Memory for the JSON documents of one request: a monotonic buffer owned by the connection
+// and reset before it is given to the next request. When a request doesn't fit, the buffer grows to the size it needed,
+// so in steady state parsing the request documents doesn't touch the global heap.
+// The arena also keeps the buffer the response body is serialized into, sent as is while the arena is held
+class RequestArena {
+  public:
+    // Requests needing more memory than this fall back to the heap instead of growing the buffer further
+    static constexpr std::size_t max_size = 1 << 20;
+
+    explicit RequestArena(std::size_t size = 4096) : size_(size), buffer_(new unsigned char[size]) {
+        resource_.emplace(buffer_.get(), size_, boost::json::storage_ptr(&upstream_));
+    }
+
+    RequestArena(const RequestArena &) = delete;
+    RequestArena &operator=(const RequestArena &) = delete;
+
+    // Values made with the storage must be destroyed before Reset
+    boost::json::storage_ptr GetStorage() noexcept { return boost::json::storage_ptr(&*resource_); }
+
+    // Empty buffer for the response body which keeps its capacity between the requests
+    std::string &GetOutput() noexcept { return output_; }
+
+    void Reset() {
+        output_.clear();
+        if (output_.capacity() > max_size) {
+            std::string{}.swap(output_);
+        }
+        resource_.reset();
+        if (const auto needed = size_ + upstream_.TakeAllocated(); needed > size_ && size_ < max_size) {
+            size_ = std::min(std::bit_ceil(needed), max_size);
+            buffer_.reset(new unsigned char[size_]);
+        }
+        resource_.emplace(buffer_.get(), size_, boost::json::storage_ptr(&upstream_));
+    }
+
+  private:
+    // Heap memory taken by the resource beyond the buffer, counted to size the buffer for the next request
+    class Upstream : public boost::json::memory_resource {
+      public:
+        std::size_t TakeAllocated() noexcept { return std::exchange(allocated_, 0); }
+
+      private:
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            allocated_ += bytes;
+            return ::operator new(bytes, std::align_val_t{alignment});
+        }
+
+        void do_deallocate(void *p, std::size_t, std::size_t alignment) override {
+            ::operator delete(p, std::align_val_t{alignment});
+        }
+
+        bool do_is_equal(const boost::json::memory_resource &other) const noexcept override { return this == &other; }
+
+        std::size_t allocated_ = 0;
+    };
+
+    std::size_t size_;
+    std::unique_ptr<unsigned char[]> buffer_;
+    Upstream upstream_;
+    std::optional<boost::json::monotonic_resource> resource_;
+    std::string output_;
+};
+
+} // namespace util
@@ -26,6 +26,57 @@ Response Response::Json(http::status status, const json::value &value) {
     return result;
 }
 
+Response Response::Json(http::status status, std::string body) {
+    StringResponse response;
+    response.result(status);
+    response.set(http::field::content_type, "application/json");
+    response.body() = std::move(body);
+    response.content_length(response.body().size());
+
+    Response result;
+    result = std::move(response);
+    return result;
+}
+
+Response Response::Json(http::status status, std::shared_ptr<const std::string> body) {
+    return Shared(status, "application/json", std::move(body));
+}
+
+Response Response::Shared(http::status status, std::string_view content_type,
+                          std::shared_ptr<const std::string> body) {
+    SharedResponse response;
+    response.result(status);
+    response.set(http::field::content_type, content_type);
+    response.body() = std::move(body);
+    response.prepare_payload();
+
+    Response result;
+    result = std::move(response);
+    return result;
+}
+
+Response Response::Borrowed(http::status status, std::string_view content_type, std::string_view body) {
+    BorrowedResponse response;
+    response.result(status);
+    response.set(http::field::content_type, content_type);
+    response.body() = {body.data(), body.size()};
+    response.prepare_payload();
+
+    Response result;
+    result = std::move(response);
+    return result;
+}
+
+Response Response::NotModified(std::string_view etag) {
+    StringResponse response;
+    response.result(http::status::not_modified);
+    response.set(http::field::etag, etag);
+
+    Response result;
+    result = std::move(response);
+    return result;
+}
+
 Response Response::File(http::status status, std::string_view mime_type, std::string_view filepath,
                         boost::system::error_code &ec) {
     FileResponse response;
@@ -52,6 +103,14 @@ Response &Response::operator=(FileResponse &&response_) {
     response = std::move(response_);
     return *this;
 }
+Response &Response::operator=(SharedResponse &&response_) {
+    response = std::move(response_);
+    return *this;
+}
+Response &Response::operator=(BorrowedResponse &&response_) {
+    response = std::move(response_);
+    return *this;
+}
 
 int Response::code() const {
     int code;
@@ -83,6 +142,11 @@ Response &&Response::allow(std::string_view allowed_methods) && {
     return std::move(*this);
 }
 
+Response &&Response::etag(std::string_view etag) && {
+    set("ETag", etag);
+    return std::move(*this);
+}
+
 void Response::finalize(unsigned http_version, bool keep_alive) {
     std::visit([&](auto &&arg) { FinalizeResponse(arg, http_version, keep_alive); }, response);
 }
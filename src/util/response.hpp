@@ -1,13 +1,15 @@
 #pragma once
 
-#include <boost/asio/strand.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/json.hpp>
 
 #include <memory>
+#include <string>
 #include <string_view>
 #include <variant>
 
+#include "shared_string_body.hpp"
+
 namespace util {
 
 namespace beast = boost::beast;
@@ -16,26 +18,40 @@ namespace json = boost::json;
 
 using StringResponse = http::response<http::string_body>;
 using FileResponse = http::response<http::file_body>;
+using SharedResponse = http::response<SharedStringBody>;
+using BorrowedResponse = http::response<http::span_body<const char>>;
 
 class Response : public std::enable_shared_from_this<Response> {
   public:
-    using Strand = beast::net::strand<beast::net::io_context::executor_type>;
-
     Response() {}
 
     static Response Text(http::status status, std::string_view body);
     static Response Json(http::status status, const json::value &value);
+    // Serialized document, e.g. written by util::JsonWriter
+    static Response Json(http::status status, std::string body);
+    // Already serialized document shared with other responses
+    static Response Json(http::status status, std::shared_ptr<const std::string> body);
+    // Body shared with other responses, e.g. a cached file
+    static Response Shared(http::status status, std::string_view content_type,
+                           std::shared_ptr<const std::string> body);
+    // Body which outlives the response and is sent without a copy, e.g. the output of util::RequestArena
+    static Response Borrowed(http::status status, std::string_view content_type, std::string_view body);
+    // The resource of the tag has not changed since the client received it
+    static Response NotModified(std::string_view etag);
     static Response File(http::status status, std::string_view mime_type, std::string_view filepath,
                          boost::system::error_code &ec);
 
     Response &operator=(StringResponse &&response_);
     Response &operator=(FileResponse &&response_);
+    Response &operator=(SharedResponse &&response_);
+    Response &operator=(BorrowedResponse &&response_);
 
     int code() const;
     std::string_view content_type() const;
     void set(std::string_view name, std::string_view value);
     Response &&no_cache() &&;
     Response &&allow(std::string_view allowed_methods) &&;
+    Response &&etag(std::string_view etag) &&;
 
     void finalize(unsigned http_version, bool keep_alive);
 
@@ -44,14 +60,6 @@ class Response : public std::enable_shared_from_this<Response> {
         std::visit([send_fn = std::move(send_fn)](auto &&arg) { send_fn(std::move(arg)); }, response);
     }
 
-    template <typename Send>
-    void send(Send &&send_fn, Strand api_strand) {
-        boost::beast::net::dispatch(
-            api_strand, [send_fn = std::move(send_fn), response = std::move(this->response)]() mutable {
-                std::visit([send_fn = std::move(send_fn)](auto &&arg) { send_fn(std::move(arg)); }, response);
-            });
-    }
-
   private:
     template <typename Body>
     static void FinalizeResponse(http::response<Body> &response, unsigned http_version, bool keep_alive) {
@@ -59,7 +67,7 @@ class Response : public std::enable_shared_from_this<Response> {
         response.keep_alive(keep_alive);
     }
 
-    std::variant<StringResponse, FileResponse> response;
+    std::variant<StringResponse, FileResponse, SharedResponse, BorrowedResponse> response;
 };
 
 } // namespace util
\ No newline at end of file
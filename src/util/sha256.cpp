@@ -0,0 +1,141 @@
+#include "sha256.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace util {
+
+namespace {
+
+constexpr std::array<std::uint32_t, 64> round_constants{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+} // namespace
+
+void Sha256::Update(std::string_view data) noexcept {
+    length_ += data.size();
+    while (!data.empty()) {
+        const std::size_t size = std::min(block_size - buffered_, data.size());
+        std::memcpy(buffer_.data() + buffered_, data.data(), size);
+        buffered_ += size;
+        data.remove_prefix(size);
+        if (buffered_ == block_size) {
+            Compress(buffer_.data());
+            buffered_ = 0;
+        }
+    }
+}
+
+Sha256::Digest Sha256::Final() noexcept {
+    const std::uint64_t bit_length = length_ * 8;
+
+    // Padding: a single one bit, zeros and the message length in bits as a big-endian number
+    buffer_[buffered_++] = 0x80;
+    if (buffered_ > block_size - 8) {
+        std::memset(buffer_.data() + buffered_, 0, block_size - buffered_);
+        Compress(buffer_.data());
+        buffered_ = 0;
+    }
+    std::memset(buffer_.data() + buffered_, 0, block_size - 8 - buffered_);
+    for (std::size_t i = 0; i < 8; ++i) {
+        buffer_[block_size - 1 - i] = static_cast<std::uint8_t>(bit_length >> (8 * i));
+    }
+    Compress(buffer_.data());
+
+    Digest digest;
+    for (std::size_t i = 0; i < state_.size(); ++i) {
+        for (std::size_t j = 0; j < 4; ++j) {
+            digest[i * 4 + j] = static_cast<std::uint8_t>(state_[i] >> (24 - 8 * j));
+        }
+    }
+    return digest;
+}
+
+void Sha256::Compress(const std::uint8_t *block) noexcept {
+    std::array<std::uint32_t, 64> w;
+    for (std::size_t i = 0; i < 16; ++i) {
+        w[i] = std::uint32_t{block[i * 4]} << 24 | std::uint32_t{block[i * 4 + 1]} << 16 |
+               std::uint32_t{block[i * 4 + 2]} << 8 | std::uint32_t{block[i * 4 + 3]};
+    }
+    for (std::size_t i = 16; i < 64; ++i) {
+        const std::uint32_t s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const std::uint32_t s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    auto [a, b, c, d, e, f, g, h] = state_;
+    for (std::size_t i = 0; i < 64; ++i) {
+        const std::uint32_t s1 = std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25);
+        const std::uint32_t choice = (e & f) ^ (~e & g);
+        const std::uint32_t temp1 = h + s1 + choice + round_constants[i] + w[i];
+        const std::uint32_t s0 = std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22);
+        const std::uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        const std::uint32_t temp2 = s0 + majority;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+    state_[5] += f;
+    state_[6] += g;
+    state_[7] += h;
+}
+
+HmacSha256::HmacSha256(std::string_view key) noexcept {
+    std::array<std::uint8_t, Sha256::block_size> padded_key{};
+    if (key.size() > Sha256::block_size) {
+        Sha256 hash;
+        hash.Update(key);
+        const auto digest = hash.Final();
+        std::memcpy(padded_key.data(), digest.data(), digest.size());
+    } else {
+        std::memcpy(padded_key.data(), key.data(), key.size());
+    }
+
+    std::array<char, Sha256::block_size> inner_pad, outer_pad;
+    for (std::size_t i = 0; i < Sha256::block_size; ++i) {
+        inner_pad[i] = static_cast<char>(padded_key[i] ^ 0x36);
+        outer_pad[i] = static_cast<char>(padded_key[i] ^ 0x5c);
+    }
+    inner_.Update({inner_pad.data(), inner_pad.size()});
+    outer_.Update({outer_pad.data(), outer_pad.size()});
+}
+
+Sha256::Digest HmacSha256::Sign(std::string_view message) const noexcept {
+    Sha256 inner = inner_;
+    inner.Update(message);
+    const auto inner_digest = inner.Final();
+
+    Sha256 outer = outer_;
+    outer.Update({reinterpret_cast<const char *>(inner_digest.data()), inner_digest.size()});
+    return outer.Final();
+}
+
+bool ConstantTimeEqual(const std::uint8_t *lhs, const std::uint8_t *rhs, std::size_t size) noexcept {
+    std::uint8_t diff = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        diff |= lhs[i] ^ rhs[i];
+    }
+    return diff == 0;
+}
+
+} // namespace util
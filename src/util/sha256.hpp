@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace util {
+
+// SHA-256 (FIPS 180-4)
+class Sha256 {
+  public:
+    static constexpr std::size_t block_size = 64;
+    using Digest = std::array<std::uint8_t, 32>;
+
+    void Update(std::string_view data) noexcept;
+
+    // The object can't be updated afterwards
+    Digest Final() noexcept;
+
+  private:
+    void Compress(const std::uint8_t *block) noexcept;
+
+    std::array<std::uint32_t, 8> state_{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    std::array<std::uint8_t, block_size> buffer_{};
+    std::size_t buffered_ = 0;
+    std::uint64_t length_ = 0;
+};
+
+// HMAC-SHA256 (RFC 2104) with the padded key absorbed once, so a short message costs two compressions
+class HmacSha256 {
+  public:
+    explicit HmacSha256(std::string_view key) noexcept;
+
+    Sha256::Digest Sign(std::string_view message) const noexcept;
+
+  private:
+    Sha256 inner_;
+    Sha256 outer_;
+};
+
+// Comparison which takes the same time wherever the buffers differ
+bool ConstantTimeEqual(const std::uint8_t *lhs, const std::uint8_t *rhs, std::size_t size) noexcept;
+
+} // namespace util
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+// Dense storage addressed by generational handles.
+// Values are kept contiguous, so iteration is a linear scan, and a handle is resolved by two array accesses.
+// Erasing a value moves the last one into its place and bumps the generation of the slot,
+// so a stale handle is detected instead of reaching a value inserted later
+template <typename T>
+class SlotMap {
+  public:
+    struct Handle {
+        std::uint32_t index = std::numeric_limits<std::uint32_t>::max();
+        std::uint32_t generation = 0;
+
+        auto operator<=>(const Handle &) const = default;
+    };
+
+    template <typename... Args>
+    Handle Emplace(Args &&...args) {
+        std::uint32_t index;
+        if (free_slots_.empty()) {
+            index = static_cast<std::uint32_t>(slots_.size());
+            slots_.push_back({});
+        } else {
+            index = free_slots_.back();
+            free_slots_.pop_back();
+        }
+        auto &slot = slots_[index];
+        slot.dense = static_cast<std::uint32_t>(values_.size());
+        values_.emplace_back(std::forward<Args>(args)...);
+        dense_to_slot_.push_back(index);
+        return {index, slot.generation};
+    }
+
+    // nullptr if the handle is stale; the pointer is valid until the next insertion or erasure
+    T *Get(Handle handle) noexcept {
+        return const_cast<T *>(std::as_const(*this).Get(handle));
+    }
+
+    const T *Get(Handle handle) const noexcept {
+        if (handle.index >= slots_.size() || slots_[handle.index].generation != handle.generation) {
+            return nullptr;
+        }
+        return &values_[slots_[handle.index].dense];
+    }
+
+    // Returns false if the handle is stale; the slot is reused by the next insertion with a new generation
+    bool Erase(Handle handle) {
+        if (!Get(handle)) {
+            return false;
+        }
+        auto &slot = slots_[handle.index];
+        const std::uint32_t last = static_cast<std::uint32_t>(values_.size() - 1);
+        if (slot.dense != last) {
+            values_[slot.dense] = std::move(values_[last]);
+            dense_to_slot_[slot.dense] = dense_to_slot_[last];
+            slots_[dense_to_slot_[slot.dense]].dense = slot.dense;
+        }
+        values_.pop_back();
+        dense_to_slot_.pop_back();
+        ++slot.generation;
+        free_slots_.push_back(handle.index);
+        return true;
+    }
+
+    std::size_t Size() const noexcept { return values_.size(); }
+
+    auto begin() noexcept { return values_.begin(); }
+    auto end() noexcept { return values_.end(); }
+    auto begin() const noexcept { return values_.begin(); }
+    auto end() const noexcept { return values_.end(); }
+
+  private:
+    struct Slot {
+        std::uint32_t dense = 0;
+        std::uint32_t generation = 0;
+    };
+
+    std::vector<T> values_;
+    std::vector<std::uint32_t> dense_to_slot_;
+    std::vector<Slot> slots_;
+    std::vector<std::uint32_t> free_slots_;
+};
+
+} // namespace util
@@ -0,0 +1,165 @@
+#include "static_cache.hpp"
+
+#include <boost/beast/core/string.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "etag.hpp"
+#include "filesystem.hpp"
+#include "mime_type.hpp"
+
+namespace util {
+
+using namespace std::literals;
+
+namespace {
+
+// Smaller files don't win enough from compression to pay for the Vary header
+constexpr std::size_t min_compressed_size = 256;
+
+bool IsText(std::string_view mime_type) {
+    return mime_type.starts_with("text/"sv) || mime_type.ends_with("javascript"sv) || mime_type.ends_with("json"sv) ||
+           mime_type.ends_with("xml"sv);
+}
+
+std::string ReadFile(const fs::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to read static file "s + path.string());
+    }
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+StaticCache::Variant MakeVariant(std::string body) {
+    auto etag = MakeContentETag(body);
+    return {std::make_shared<const std::string>(std::move(body)), std::move(etag)};
+}
+
+std::string_view Trim(std::string_view value) {
+    constexpr std::string_view spaces = " \t";
+    value.remove_prefix(std::min(value.find_first_not_of(spaces), value.size()));
+    value.remove_suffix(value.size() - std::min(value.find_last_not_of(spaces) + 1, value.size()));
+    return value;
+}
+
+// q-value of the coding in an Accept-Encoding header; codings which aren't listed get the value of "*",
+// identity is acceptable unless it is excluded explicitly
+double GetQuality(std::string_view accept_encoding, ContentEncoding encoding) {
+    using boost::beast::iequals;
+
+    const auto token = GetEncodingToken(encoding);
+    std::optional<double> any;
+    while (!accept_encoding.empty()) {
+        const auto comma = accept_encoding.find(',');
+        auto item = accept_encoding.substr(0, comma);
+        accept_encoding.remove_prefix(comma == std::string_view::npos ? accept_encoding.size() : comma + 1);
+
+        const auto semicolon = item.find(';');
+        const auto coding = Trim(item.substr(0, semicolon));
+        double quality = 1.0;
+        if (semicolon != std::string_view::npos) {
+            auto parameter = Trim(item.substr(semicolon + 1));
+            if (parameter.starts_with("q="sv) || parameter.starts_with("Q="sv)) {
+                parameter.remove_prefix(2);
+                std::from_chars(parameter.data(), parameter.data() + parameter.size(), quality);
+            }
+        }
+
+        if (iequals(coding, token)) {
+            return quality;
+        } else if (coding == "*"sv) {
+            any = quality;
+        }
+    }
+    return any.value_or(encoding == ContentEncoding::IDENTITY ? 1.0 : 0.0);
+}
+
+} // namespace
+
+StaticCache::StaticCache(const fs::path &root) {
+    if (!fs::is_directory(root)) {
+        throw std::runtime_error("Static files root "s + root.string() + " is not a directory"s);
+    }
+
+    const auto base_path = fs::canonical(root);
+    for (const auto &entry : fs::recursive_directory_iterator(base_path)) {
+        // Symbolic links leading out of the root are not served
+        if (entry.is_regular_file() && ValidatePath(fs::canonical(entry.path()), base_path)) {
+            Load(base_path, entry.path());
+        }
+    }
+}
+
+void StaticCache::Load(const fs::path &root, const fs::path &path) {
+    Asset asset{.mime_type = GetMimeType(path.extension().string()), .path = path};
+    if (fs::file_size(path) <= max_cached_size) {
+        auto content = ReadFile(path);
+        if (content.size() >= min_compressed_size) {
+            // A variant is kept only if it is notably smaller, images and archives are sent as they are
+            auto add_variant = [&asset, size = content.size()](ContentEncoding encoding, std::string body) {
+                if (body.size() < size - size / 8) {
+                    asset.variants[static_cast<std::size_t>(encoding)] = MakeVariant(std::move(body));
+                }
+            };
+            add_variant(ContentEncoding::GZIP, GzipCompress(content));
+            add_variant(ContentEncoding::BROTLI, BrotliCompress(content, IsText(asset.mime_type)));
+        }
+        asset.variants[static_cast<std::size_t>(ContentEncoding::IDENTITY)] = MakeVariant(std::move(content));
+    }
+
+    assets_.emplace("/"s + path.lexically_relative(root).generic_string(), std::move(asset));
+}
+
+const StaticCache::Asset *StaticCache::Find(std::string_view target) const {
+    auto path = target.substr(0, target.find('?'));
+    if (path == "/"sv) {
+        path = "/index.html"sv;
+    }
+
+    if (auto it = assets_.find(path); it != assets_.end()) {
+        return &it->second;
+    }
+    // Targets like /js/../index.html are rare, so they are normalized only when the direct lookup fails
+    if (path.find("/."sv) != std::string_view::npos) {
+        const auto normal = fs::path(path).lexically_normal().generic_string();
+        if (auto it = assets_.find(normal); it != assets_.end()) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+bool StaticCache::IsOutsideRoot(std::string_view target) {
+    auto path = target.substr(0, target.find('?'));
+    if (path.find(".."sv) == std::string_view::npos) {
+        return false;
+    }
+    path.remove_prefix(std::min<std::size_t>(1, path.size()));
+    const auto normal = fs::path(path).lexically_normal();
+    return !normal.empty() && *normal.begin() == ".."sv;
+}
+
+ContentEncoding NegotiateEncoding(const StaticCache::Asset &asset, std::string_view accept_encoding) {
+    auto best = ContentEncoding::IDENTITY;
+    double best_quality = GetQuality(accept_encoding, best);
+    for (auto encoding : {ContentEncoding::GZIP, ContentEncoding::BROTLI}) {
+        const auto &variant = asset.GetVariant(encoding);
+        if (!variant) {
+            continue;
+        }
+        const double quality = GetQuality(accept_encoding, encoding);
+        const auto &best_variant = asset.GetVariant(best);
+        if (quality > 0 && (quality > best_quality || (quality == best_quality &&
+                                                       variant->body->size() < best_variant->body->size()))) {
+            best = encoding;
+            best_quality = quality;
+        }
+    }
+    return best;
+}
+
+} // namespace util
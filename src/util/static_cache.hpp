@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "compression.hpp"
+#include "string_hash.hpp"
+
+namespace util {
+
+namespace fs = std::filesystem;
+
+// Files of the static root loaded into memory at startup together with their compressed variants and tags.
+// Requests are served by a lookup of the target; files added or changed later are not seen until restart
+class StaticCache {
+  public:
+    // Larger files stay on disk and are sent from there
+    static constexpr std::size_t max_cached_size = 8 << 20;
+
+    // Encoded body of a file
+    struct Variant {
+        std::shared_ptr<const std::string> body;
+        std::string etag;
+    };
+
+    struct Asset {
+        std::string_view mime_type;
+        fs::path path;
+        // Indexed by ContentEncoding; the identity variant is empty for a file kept on disk
+        std::array<std::optional<Variant>, 3> variants;
+
+        const std::optional<Variant> &GetVariant(ContentEncoding encoding) const {
+            return variants[static_cast<std::size_t>(encoding)];
+        }
+
+        bool IsCached() const noexcept { return GetVariant(ContentEncoding::IDENTITY).has_value(); }
+
+        // Whether the response depends on Accept-Encoding
+        bool IsNegotiated() const noexcept {
+            return GetVariant(ContentEncoding::GZIP) || GetVariant(ContentEncoding::BROTLI);
+        }
+    };
+
+    explicit StaticCache(const fs::path &root);
+
+    // Asset of the target path, the query is ignored; "/" is the index page
+    const Asset *Find(std::string_view target) const;
+
+    // Whether the target refers to a file outside of the root, e.g. through ".."
+    static bool IsOutsideRoot(std::string_view target);
+
+  private:
+    void Load(const fs::path &root, const fs::path &path);
+
+    std::unordered_map<std::string, Asset, string_hash, std::equal_to<>> assets_;
+};
+
+// The variant of the asset the client accepts with the highest q-value, ties go to the smaller variant
+ContentEncoding NegotiateEncoding(const StaticCache::Asset &asset, std::string_view accept_encoding);
+
+} // namespace util
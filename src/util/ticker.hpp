@@ -1,7 +1,11 @@
+#pragma once
+
 #include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/http.hpp>
 
+#include <chrono>
+#include <functional>
 #include <memory>
 
 namespace util {
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+namespace util {
+
+// Value built once per version of its source and reused until the version changes
+template <typename T>
+class VersionedCache {
+  public:
+    template <typename Fn>
+    const T &Get(std::uint64_t version, Fn &&make) {
+        if (!value_ || version_ != version) {
+            value_ = make();
+            version_ = version;
+        }
+        return *value_;
+    }
+
+  private:
+    std::optional<T> value_;
+    std::uint64_t version_ = 0;
+};
+
+} // namespace util
@@ -0,0 +1,107 @@
+#include "worker_pool.hpp"
+
+namespace util {
+
+WorkerPool::WorkerPool(unsigned num_threads) {
+    // The last queue belongs to the thread calling RunAll
+    for (unsigned i = 0; i <= num_threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(num_threads);
+    for (unsigned i = 0; i < num_threads; ++i) {
+        workers_.emplace_back([this, i](std::stop_token stop_token) { WorkerLoop(stop_token, i); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    for (auto &worker : workers_) {
+        worker.request_stop();
+    }
+    workers_.clear();
+}
+
+void WorkerPool::RunAll(std::vector<Task> tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+
+    remaining_ = tasks.size();
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        auto &queue = *queues_[i % queues_.size()];
+        std::lock_guard lock{queue.mutex};
+        queue.tasks.push_back(std::move(tasks[i]));
+    }
+    {
+        std::lock_guard lock{mutex_};
+        ++generation_;
+    }
+    wake_up_.notify_all();
+
+    const std::size_t own_queue = queues_.size() - 1;
+    while (RunOne(own_queue)) {
+    }
+
+    std::exception_ptr exception;
+    {
+        std::unique_lock lock{mutex_};
+        done_.wait(lock, [this] { return remaining_ == 0; });
+        std::swap(exception, exception_);
+    }
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void WorkerPool::WorkerLoop(std::stop_token stop_token, std::size_t index) {
+    std::size_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock{mutex_};
+            if (!wake_up_.wait(lock, stop_token, [&] { return generation_ != seen_generation; })) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+        while (RunOne(index)) {
+        }
+    }
+}
+
+bool WorkerPool::RunOne(std::size_t index) {
+    Task task;
+    // Own tasks are taken from the back, foreign ones are stolen from the front
+    for (std::size_t i = 0; i < queues_.size() && !task; ++i) {
+        auto &queue = *queues_[(index + i) % queues_.size()];
+        std::lock_guard lock{queue.mutex};
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+
+    try {
+        task();
+    } catch (...) {
+        std::lock_guard lock{mutex_};
+        if (!exception_) {
+            exception_ = std::current_exception();
+        }
+    }
+
+    if (--remaining_ == 0) {
+        std::lock_guard lock{mutex_};
+        done_.notify_all();
+    }
+    return true;
+}
+
+} // namespace util
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+// Пул потоков с перехватом задач (work stealing).
+// Задачи пакета раскладываются по очередям рабочих потоков; освободившийся поток забирает задачи из чужих очередей.
+// Вызывающий поток тоже выполняет задачи и возвращается только после завершения всего пакета.
+class WorkerPool {
+  public:
+    using Task = std::function<void()>;
+
+    explicit WorkerPool(unsigned num_threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // Run every task and wait for all of them; batches must not be submitted concurrently.
+    // The first exception thrown by a task is rethrown after the whole batch has finished
+    void RunAll(std::vector<Task> tasks);
+
+    // Number of threads executing a batch, including the calling one
+    std::size_t GetConcurrency() const noexcept { return queues_.size(); }
+
+  private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(std::stop_token stop_token, std::size_t index);
+    bool RunOne(std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    std::mutex mutex_;
+    std::condition_variable_any wake_up_;
+    std::condition_variable done_;
+    std::size_t generation_ = 0;
+    std::atomic<std::size_t> remaining_ = 0;
+    std::exception_ptr exception_;
+
+    std::vector<std::jthread> workers_;
+};
+
+} // namespace util
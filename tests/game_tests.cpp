@@ -0,0 +1,118 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+
+#include "model/model.hpp"
+
+using namespace model;
+
+namespace {
+
+Game::Maps MakeMaps(std::size_t max_players) {
+    Map::Roads roads;
+    roads.emplace_back(Orientation::HORIZONTAL, Point{0, 0}, 10);
+    Map map{Map::Id{"m1"}, "Map 1", std::move(roads), Map::Buildings{}, Map::Offices{}};
+    map.SetDogSpeed(1);
+    map.SetMaxPlayers(max_players);
+
+    Game::Maps maps;
+    maps.push_back(std::move(map));
+    return maps;
+}
+
+Player *FindPlayer(Game &game, Token token) {
+    const auto hex = token.ToHex();
+    return game.GetPlayer({hex.data(), hex.size()});
+}
+
+std::vector<std::size_t> GetInstances(const Game &game) {
+    std::vector<std::size_t> instances;
+    game.ForEachSession([&instances](const GameSession &session) { instances.push_back(session.GetInstance()); });
+    return instances;
+}
+
+} // namespace
+
+SCENARIO("Sessions are removed when their last player leaves") {
+    GIVEN("a map with two players per session and three players") {
+        Game game{MakeMaps(2)};
+        game.SetRandomSeed(42);
+        const auto map = *game.FindMap(Map::Id{"m1"});
+        const auto first = game.AddPlayer("first", game.PlaceSession(map)).second;
+        const auto second = game.AddPlayer("second", game.PlaceSession(map)).second;
+        const auto third = game.AddPlayer("third", game.PlaceSession(map)).second;
+        REQUIRE(GetInstances(game) == std::vector<std::size_t>{0, 1});
+
+        WHEN("the only player of a session leaves") {
+            REQUIRE(game.RemovePlayer(third));
+
+            THEN("the session is removed and the token is forgotten") {
+                CHECK(GetInstances(game) == std::vector<std::size_t>{0});
+                CHECK(FindPlayer(game, third) == nullptr);
+                CHECK_FALSE(game.RemovePlayer(third));
+            }
+
+            AND_WHEN("the next player doesn't fit the remaining session") {
+                auto &session = game.PlaceSession(map);
+                auto [player, token] = game.AddPlayer("fourth", session);
+
+                THEN("the slot of the removed session is reused") {
+                    CHECK(session.GetInstance() == 1);
+                    CHECK(GetInstances(game) == std::vector<std::size_t>{0, 1});
+                    CHECK(FindPlayer(game, token) == player);
+                }
+            }
+        }
+
+        WHEN("a player of the full session leaves") {
+            REQUIRE(game.RemovePlayer(first));
+
+            THEN("the next player is placed into the freed place") {
+                auto &session = game.PlaceSession(map);
+                CHECK(session.GetInstance() == 0);
+                CHECK(session.GetDogs().Size() == 1);
+                CHECK(FindPlayer(game, second)->GetSession().GetInstance() == 0);
+            }
+        }
+
+        WHEN("every player leaves") {
+            REQUIRE(game.RemovePlayer(second));
+            REQUIRE(game.RemovePlayer(first));
+            REQUIRE(game.RemovePlayer(third));
+
+            THEN("no session is left and a new one starts from the first instance") {
+                CHECK(GetInstances(game).empty());
+                CHECK(game.PlaceSession(map).GetInstance() == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Signed tokens belong to their game") {
+    GIVEN("a game with signed tokens and another one started with the same key") {
+        Game first{MakeMaps(2)};
+        Game second{MakeMaps(2)};
+        first.SetTokenKey("key");
+        second.SetTokenKey("key");
+        const auto map = *first.FindMap(Map::Id{"m1"});
+        const auto [player, token] = first.AddPlayer("first", first.PlaceSession(map));
+        REQUIRE(FindPlayer(first, token) == player);
+
+        WHEN("the other game gets a player with the same id") {
+            const auto &session = first.GetPlayer(Map::Id{"m1"}, player->GetId()).GetSession();
+            second.RestorePlayer(Map::Id{"m1"}, 0, player->GetId(), "second", Token{1, 1},
+                                 session.GetDogStore().GetState(player->GetDog().GetIndex()));
+
+            THEN("the token of the first game doesn't reach it") {
+                CHECK(FindPlayer(second, token) == nullptr);
+            }
+            AND_WHEN("the nonce of the first game is restored") {
+                second.RestoreTokenNonce(first.GetTokenSigner()->GetNonce());
+
+                THEN("the token is accepted") {
+                    CHECK(FindPlayer(second, token) != nullptr);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <boost/asio/io_context.hpp>
+
+#include <filesystem>
+#include <memory>
+
+#include "game_journal.hpp"
+
+using namespace model;
+
+namespace {
+
+Game::Maps MakeMaps() {
+    Map::Roads roads;
+    roads.emplace_back(Orientation::HORIZONTAL, Point{0, 0}, 100);
+    Map map{Map::Id{"m1"}, "Map 1", std::move(roads), Map::Buildings{}, Map::Offices{}};
+    map.SetDogSpeed(1);
+
+    Game::Maps maps;
+    maps.push_back(std::move(map));
+    return maps;
+}
+
+} // namespace
+
+SCENARIO("Journal replay") {
+    GIVEN("a game which records its changes to a journal") {
+        const auto path = std::filesystem::temp_directory_path() / "dog_story_journal_tests";
+        boost::asio::io_context ioc;
+        Game game{MakeMaps()};
+        auto journal = std::make_shared<game_journal::Journal>(ioc, path, 1);
+        game.SetListener(journal);
+        const auto map = *game.FindMap(Map::Id{"m1"});
+
+        auto [player, token] = game.AddPlayer("dog", game.PlaceSession(map));
+        const auto id = player->GetId();
+        game.Tick(100);
+        ioc.run();
+        ioc.restart();
+        const auto size = std::filesystem::file_size(path);
+
+        WHEN("nothing moves") {
+            game.Tick(100);
+            game.Tick(100);
+            ioc.run();
+
+            THEN("the ticks aren't written") {
+                CHECK(std::filesystem::file_size(path) == size);
+            }
+        }
+
+        WHEN("the dog moves between idle ticks") {
+            game.MovePlayer(*player, Direction::EAST);
+            game.Tick(250);
+            game.Tick(250);
+            game.MovePlayer(game.GetPlayer(Map::Id{"m1"}, id), Direction::NO);
+            game.Tick(100);
+            game.Tick(100);
+            ioc.run();
+
+            THEN("the replayed game has the same dog") {
+                Game replayed{MakeMaps()};
+                const auto result = game_journal::Replay(replayed, path, 1);
+                CHECK(result.records == 5);
+
+                const auto &expected = game.GetPlayer(Map::Id{"m1"}, id);
+                const auto &actual = replayed.GetPlayer(Map::Id{"m1"}, id);
+                const auto expected_state =
+                    expected.GetSession().GetDogStore().GetState(expected.GetDog().GetIndex());
+                const auto actual_state = actual.GetSession().GetDogStore().GetState(actual.GetDog().GetIndex());
+                CHECK(actual_state.x == expected_state.x);
+                CHECK(actual_state.y == expected_state.y);
+                CHECK(actual_state.x != 0);
+            }
+        }
+
+        std::filesystem::remove(path);
+    }
+}
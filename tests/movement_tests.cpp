@@ -0,0 +1,203 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "model/model.hpp"
+
+using namespace model;
+
+namespace {
+
+#ifdef FIXED_POINT_COORDINATES
+// The half width of a road isn't exact in fixed point
+constexpr double tolerance = 1e-3;
+#else
+constexpr double tolerance = 1e-9;
+#endif
+
+// Movement of the first version of the game: every tick the dog is bounded by the road of its direction at its
+// rounded position, the road listed last wins at the points shared by several roads. That version filled its
+// point table from the moved-from roads, so the table was empty and a moving dog threw; here it is filled
+class ReferenceDog {
+  public:
+    ReferenceDog(const Map::Roads &roads, std::pair<double, double> position) : roads_(roads), position_(position) {
+        for (std::size_t i = 0; i < roads.size(); ++i) {
+            const auto [start, end] = std::minmax({roads[i].GetStart(), roads[i].GetEnd()},
+                                                  [](Point lhs, Point rhs) { return lhs.x + lhs.y < rhs.x + rhs.y; });
+            const bool horizontal = roads[i].IsHorizontal();
+            for (auto point = start; point.x <= end.x && point.y <= end.y; ++(horizontal ? point.x : point.y)) {
+                points_[horizontal ? 0 : 1][{point.x, point.y}] = i;
+            }
+        }
+    }
+
+    void Move(Direction direction, double speed) {
+        switch (direction) {
+        case Direction::NORTH:
+            speed_ = {0, -speed};
+            break;
+        case Direction::SOUTH:
+            speed_ = {0, speed};
+            break;
+        case Direction::WEST:
+            speed_ = {-speed, 0};
+            break;
+        case Direction::EAST:
+            speed_ = {speed, 0};
+            break;
+        default:
+            speed_ = {0, 0};
+        }
+    }
+
+    void Tick(double milliseconds) {
+        auto [dx, dy] = speed_;
+        if (dx == 0 && dy == 0) {
+            return;
+        }
+        auto &[x, y] = position_;
+        const bool horizontal = dx != 0;
+        const auto &road = roads_[points_[horizontal ? 0 : 1].at({std::lround(x), std::lround(y)})];
+        const auto start = horizontal ? road.GetStart().x : road.GetStart().y;
+        const auto end = horizontal ? road.GetEnd().x : road.GetEnd().y;
+        const double min = std::min(start, end) - Map::road_half_width, max = std::max(start, end) + Map::road_half_width;
+
+        auto &coord = horizontal ? x : y;
+        coord += (horizontal ? dx : dy) * (milliseconds / 1000.0);
+        if (coord > max || coord < min) {
+            coord = std::clamp(coord, min, max);
+            speed_ = {0, 0};
+        }
+    }
+
+    std::pair<double, double> GetPosition() const { return position_; }
+
+  private:
+    const Map::Roads &roads_;
+    std::pair<double, double> position_;
+    std::pair<double, double> speed_{0, 0};
+    std::map<std::pair<int, int>, std::size_t> points_[2];
+};
+
+struct Step {
+    Direction direction;
+    int ticks;
+};
+
+class Movement {
+  public:
+    explicit Movement(Map::Roads roads) : roads_(roads), game_(MakeMaps(std::move(roads))) {
+        const auto map = *game_.FindMap(Map::Id{"m1"});
+        id_ = game_.AddPlayer("dog", game_.PlaceSession(map)).first->GetId();
+    }
+
+    // Both dogs take the steps, their positions are compared after every tick
+    void Run(const std::vector<Step> &steps, double milliseconds) {
+        ReferenceDog reference{roads_, GetPosition()};
+        for (const auto &[direction, ticks] : steps) {
+            game_.MovePlayer(GetPlayer(), direction);
+            reference.Move(direction, 1);
+            for (int i = 0; i < ticks; ++i) {
+                game_.Tick(milliseconds);
+                reference.Tick(milliseconds);
+                const auto [x, y] = GetPosition();
+                const auto [expected_x, expected_y] = reference.GetPosition();
+                CHECK(std::abs(x - expected_x) < tolerance);
+                CHECK(std::abs(y - expected_y) < tolerance);
+            }
+        }
+    }
+
+    void Move(Direction direction, int ticks, double milliseconds) {
+        game_.MovePlayer(GetPlayer(), direction);
+        for (int i = 0; i < ticks; ++i) {
+            game_.Tick(milliseconds);
+        }
+    }
+
+    std::pair<double, double> GetPosition() {
+        const auto &player = GetPlayer();
+        const auto state = player.GetSession().GetDogStore().GetState(player.GetDog().GetIndex());
+        return {static_cast<double>(state.x), static_cast<double>(state.y)};
+    }
+
+  private:
+    static Game::Maps MakeMaps(Map::Roads roads) {
+        Map map{Map::Id{"m1"}, "Map 1", std::move(roads), Map::Buildings{}, Map::Offices{}};
+        map.SetDogSpeed(1);
+        Game::Maps maps;
+        maps.push_back(std::move(map));
+        return maps;
+    }
+
+    Player &GetPlayer() { return game_.GetPlayer(Map::Id{"m1"}, id_); }
+
+    Map::Roads roads_;
+    Game game_;
+    Dog::Id id_{0};
+};
+
+Map::Roads MakeRoads(std::initializer_list<std::pair<Point, Point>> ends) {
+    Map::Roads roads;
+    for (const auto &[start, end] : ends) {
+        if (start.y == end.y) {
+            roads.emplace_back(Orientation::HORIZONTAL, start, end.x);
+        } else {
+            roads.emplace_back(Orientation::VERTICAL, start, end.y);
+        }
+    }
+    return roads;
+}
+
+} // namespace
+
+SCENARIO("Dogs move as in the first version of the game") {
+    // 1/8 of a second at the speed of 1 is exact in both coordinate modes
+    constexpr double tick = 125;
+
+    GIVEN("a single road") {
+        Movement movement{MakeRoads({{{0, 0}, {10, 0}}})};
+        THEN("the dog stops at the edges of the road") {
+            movement.Run({{Direction::EAST, 100}, {Direction::WEST, 30}, {Direction::NO, 5}, {Direction::WEST, 100}},
+                         tick);
+        }
+    }
+    GIVEN("a road given from its end") {
+        Movement movement{MakeRoads({{{10, 0}, {0, 0}}})};
+        THEN("the dog is bounded the same way") {
+            movement.Run({{Direction::WEST, 100}, {Direction::EAST, 100}}, tick);
+        }
+    }
+    GIVEN("crossing roads") {
+        Movement movement{MakeRoads({{{0, 0}, {10, 0}}, {{5, -5}, {5, 5}}})};
+        THEN("the dog turns at the crossing") {
+            movement.Run({{Direction::EAST, 40}, {Direction::SOUTH, 60}, {Direction::NORTH, 100}}, tick);
+        }
+    }
+    GIVEN("collinear roads joined at a junction") {
+        Movement movement{MakeRoads({{{0, 0}, {10, 0}}, {{10, 0}, {20, 0}}, {{20, 0}, {20, 10}}})};
+        THEN("the dog passes the junction when a tick lands on it") {
+            movement.Run({{Direction::EAST, 200}, {Direction::SOUTH, 100}, {Direction::NORTH, 10}}, tick);
+        }
+    }
+}
+
+SCENARIO("Dogs pass junctions whatever the tick") {
+    GIVEN("collinear roads joined at a junction") {
+        Movement movement{MakeRoads({{{0, 0}, {10, 0}}, {{10, 0}, {20, 0}}})};
+
+        WHEN("a single tick carries the dog over the junction") {
+            movement.Move(Direction::EAST, 1, 9000);
+            movement.Move(Direction::EAST, 1, 2000);
+
+            // The first version stopped the dog at the end of the first road, at 10.4
+            THEN("the dog goes on along the next road") {
+                CHECK(std::abs(movement.GetPosition().first - 11) < tolerance);
+            }
+        }
+    }
+}
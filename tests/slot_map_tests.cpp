@@ -0,0 +1,54 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+#include "util/slot_map.hpp"
+
+using util::SlotMap;
+
+SCENARIO("Slot map handles") {
+    GIVEN("a slot map with several values") {
+        SlotMap<std::string> values;
+        const auto first = values.Emplace("first");
+        const auto second = values.Emplace("second");
+        const auto third = values.Emplace("third");
+
+        WHEN("a value is erased") {
+            REQUIRE(values.Erase(first));
+
+            THEN("its handle is stale and the other values are still reachable") {
+                CHECK(values.Get(first) == nullptr);
+                CHECK(*values.Get(second) == "second");
+                CHECK(*values.Get(third) == "third");
+                CHECK(values.Size() == 2);
+                CHECK_FALSE(values.Erase(first));
+            }
+
+            AND_WHEN("the slot is reused by a new value") {
+                const auto fourth = values.Emplace("fourth");
+
+                THEN("the new value gets the slot with another generation") {
+                    CHECK(fourth.index == first.index);
+                    CHECK(fourth.generation != first.generation);
+                }
+                THEN("the stale handle doesn't reach the new value") {
+                    CHECK(values.Get(first) == nullptr);
+                    CHECK(*values.Get(fourth) == "fourth");
+                    CHECK_FALSE(values.Erase(first));
+                    CHECK(values.Size() == 3);
+                }
+            }
+        }
+
+        WHEN("every value is erased") {
+            REQUIRE(values.Erase(second));
+            REQUIRE(values.Erase(third));
+            REQUIRE(values.Erase(first));
+
+            THEN("the map is empty") {
+                CHECK(values.Size() == 0);
+                CHECK(values.begin() == values.end());
+            }
+        }
+    }
+}